@@ -0,0 +1,104 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QTest>
+
+#include <cmath>
+
+#include "utils/envelope.h"
+
+using namespace Phonon::MPV;
+
+static QVector<qint16> triplets(const QByteArray& envelope) {
+    const auto data{reinterpret_cast<const qint16*>(envelope.constData())};
+    return QVector<qint16>(data, data + envelope.size() / static_cast<int>(sizeof(qint16)));
+}
+
+class EnvelopeTest : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void reduceBlock() {
+        // Not a multiple of the lane count, the tail takes the scalar path.
+        float samples[19];
+        auto squares{0.0};
+        for(auto i{0}; i < 19; i++) {
+            samples[i] = (i - 9) / 10.0f;
+            squares += samples[i] * samples[i];
+        }
+        EnvelopeBlock block{0, 0, 0, 0};
+        reduce(samples, 19, &block);
+        QCOMPARE(block.min, -0.9f);
+        QCOMPARE(block.max, 0.9f);
+        QCOMPARE(block.samples, 19);
+        QVERIFY(std::abs(block.squares - squares) < 1e-5);
+    }
+
+    void reduceInParts() {
+        float samples[40];
+        for(auto i{0}; i < 40; i++)
+            samples[i] = std::sin(i * 0.3f) * 0.5f;
+        EnvelopeBlock whole{0, 0, 0, 0}, parts{0, 0, 0, 0};
+        reduce(samples, 40, &whole);
+        reduce(samples, 13, &parts);
+        reduce(samples + 13, 27, &parts);
+        QCOMPARE(parts.min, whole.min);
+        QCOMPARE(parts.max, whole.max);
+        QCOMPARE(parts.samples, whole.samples);
+        QVERIFY(std::abs(parts.squares - whole.squares) < 1e-5);
+    }
+
+    void reduceStartsAtFirstSample() {
+        // A fresh block must not keep its zero initialized bounds.
+        const float samples[]{0.25f, 0.5f, 0.75f};
+        EnvelopeBlock block{0, 0, 0, 0};
+        reduce(samples, 3, &block);
+        QCOMPARE(block.min, 0.25f);
+        QCOMPARE(block.max, 0.75f);
+    }
+
+    void mergeBlocks() {
+        const std::vector<EnvelopeBlock> blocks{
+            {-0.5f, 0.5f, 0.25 * 4, 4},
+            {-1.0f, 0.25f, 0.25 * 4, 4},
+            {0.0f, 0.0f, 0, 4},
+            {-0.125f, 2.0f, 1.0 * 4, 4},
+        };
+        QCOMPARE(triplets(envelope(blocks, 2)), QVector<qint16>({
+            -32767, 16384, 16384,
+            // Clamped to full scale
+            -4096, 32767, 23170,
+        }));
+    }
+
+    void repeatBlocksForShortFiles() {
+        const std::vector<EnvelopeBlock> blocks{
+            {-0.5f, 0.5f, 0.25 * 4, 4},
+            {0.0f, 0.0f, 0, 4},
+        };
+        QCOMPARE(triplets(envelope(blocks, 4)), QVector<qint16>({
+            -16384, 16384, 16384,
+            -16384, 16384, 16384,
+            0, 0, 0,
+            0, 0, 0,
+        }));
+    }
+};
+
+QTEST_GUILESS_MAIN(EnvelopeTest)
+
+#include "envelopetest.moc"
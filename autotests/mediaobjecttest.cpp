@@ -0,0 +1,111 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QThread>
+#include <QUrl>
+
+#include <cmath>
+
+#include "backend.h"
+#include "mediaobject.h"
+
+using namespace Phonon;
+using namespace Phonon::MPV;
+
+// Writes a mono 16 bit PCM WAV file with a sine tone of \p seconds.
+static bool writeTone(const QString& path, int seconds) {
+    const quint32 rate{8000};
+    const quint32 bytes{rate * 2 * seconds};
+    QFile file{path};
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream out{&file};
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.writeRawData("RIFF", 4);
+    out << quint32(36 + bytes);
+    out.writeRawData("WAVEfmt ", 8);
+    out << quint32(16) << quint16(1) << quint16(1) << rate << quint32(rate * 2) << quint16(2) << quint16(16);
+    out.writeRawData("data", 4);
+    out << bytes;
+    for(quint32 i{0}; i < rate * seconds; i++)
+        out << static_cast<qint16>(8000 * std::sin(i * 2 * M_PI * 440 / rate));
+    return out.status() == QDataStream::Ok;
+}
+
+class MediaObjectTest : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase() {
+        // Keep the user's config and caches out, and play without an audio device.
+        QVERIFY(m_home.isValid());
+        qputenv("XDG_CONFIG_HOME", QFile::encodeName(m_home.filePath(QStringLiteral("config"))));
+        qputenv("XDG_CACHE_HOME", QFile::encodeName(m_home.filePath(QStringLiteral("cache"))));
+        qputenv("PHONON_MPV_POOL_SIZE", "0");
+        QVERIFY(QDir().mkpath(m_home.filePath(QStringLiteral("config/Phonon"))));
+        QFile config{m_home.filePath(QStringLiteral("config/Phonon/mpv.conf"))};
+        QVERIFY(config.open(QIODevice::WriteOnly));
+        config.write("ao=null\n");
+        config.close();
+
+        QVERIFY(writeTone(m_home.filePath(QStringLiteral("short.wav")), 2));
+        QVERIFY(writeTone(m_home.filePath(QStringLiteral("long.wav")), 10));
+        qRegisterMetaType<MediaSource>();
+        m_backend = new Backend(this, {});
+    }
+
+    void cleanupTestCase() {
+        delete m_backend;
+    }
+
+    void clockRunsAfterGaplessSwitch() {
+        const auto object{qobject_cast<MediaObject*>(m_backend->createObject(BackendInterface::MediaObjectClass, this, {}))};
+        QVERIFY(object);
+        const MediaSource next{QUrl::fromLocalFile(m_home.filePath(QStringLiteral("long.wav")))};
+        // Like the frontend, queue the next source once asked for it.
+        connect(object, &MediaObject::aboutToFinish, object, [object, next] { object->setNextSource(next); });
+        QSignalSpy switched(object, &MediaObject::currentSourceChanged);
+
+        object->setSource(MediaSource(QUrl::fromLocalFile(m_home.filePath(QStringLiteral("short.wav")))));
+        object->play();
+        QVERIFY(switched.wait(10000));
+        QCOMPARE(switched.last().at(0).value<MediaSource>().url(), next.url());
+        QCOMPARE(object->state(), PlayingState);
+
+        // Without events processed only the interpolation advances the time.
+        QTest::qWait(200);
+        const auto before{object->currentTime()};
+        QThread::msleep(300);
+        const auto after{object->currentTime()};
+        QVERIFY2(after - before >= 250, qPrintable(QStringLiteral("%1 -> %2").arg(before).arg(after)));
+        delete object;
+    }
+
+private:
+    QTemporaryDir m_home;
+    Backend* m_backend{nullptr};
+};
+
+QTEST_GUILESS_MAIN(MediaObjectTest)
+
+#include "mediaobjecttest.moc"
@@ -0,0 +1,119 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QTest>
+#include <QThread>
+
+#include <atomic>
+
+#include "playbackclock.h"
+
+using namespace Phonon::MPV;
+
+class PlaybackClockTest : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void stoppedClockHolds() {
+        PlaybackClock clock;
+        QCOMPARE(clock.time(), qint64(0));
+        clock.update(5.0);
+        QThread::msleep(20);
+        QCOMPARE(clock.time(), qint64(5000));
+    }
+
+    void runningClockExtrapolates() {
+        PlaybackClock clock;
+        clock.update(1.0);
+        clock.setRunning(true);
+        QThread::msleep(100);
+        const auto time{clock.time()};
+        QVERIFY2(time >= 1100 && time < 1600, qPrintable(QString::number(time)));
+    }
+
+    void speedScalesExtrapolation() {
+        PlaybackClock clock;
+        clock.setSpeed(2.0);
+        clock.update(1.0);
+        clock.setRunning(true);
+        QThread::msleep(100);
+        const auto time{clock.time()};
+        QVERIFY2(time >= 1200 && time < 2000, qPrintable(QString::number(time)));
+    }
+
+    void pauseKeepsElapsedTime() {
+        PlaybackClock clock;
+        clock.update(1.0);
+        clock.setRunning(true);
+        QThread::msleep(50);
+        clock.setRunning(false);
+        const auto paused{clock.time()};
+        QVERIFY(paused >= 1050);
+        QThread::msleep(50);
+        QCOMPARE(clock.time(), paused);
+    }
+
+    void extrapolationIsCapped() {
+        // A stalled position update must not run the clock away.
+        PlaybackClock clock;
+        clock.update(1.0);
+        clock.setRunning(true);
+        QThread::msleep(1200);
+        QCOMPARE(clock.time(), qint64(2000));
+    }
+
+    void resetStops() {
+        PlaybackClock clock;
+        clock.setSpeed(1.5);
+        clock.update(10.0);
+        clock.setRunning(true);
+        clock.reset(3.0);
+        QThread::msleep(20);
+        QCOMPARE(clock.time(), qint64(3000));
+        // The speed outlives a reset.
+        clock.setRunning(true);
+        QThread::msleep(100);
+        QVERIFY(clock.time() >= 3150);
+    }
+
+    void concurrentReadsAreConsistent() {
+        // Stopped, time() reports the written positions exactly and never goes back.
+        PlaybackClock clock;
+        std::atomic<bool> done{false};
+        auto writer{QThread::create([&clock, &done] {
+            for(auto i{1}; i <= 200000; i++)
+                clock.update(i / 1000.0);
+            done = true;
+        })};
+        writer->start();
+        qint64 last{0};
+        auto ordered{true};
+        while(!done) {
+            const auto time{clock.time()};
+            ordered = ordered && time >= last;
+            last = time;
+        }
+        writer->wait();
+        delete writer;
+        QVERIFY(ordered);
+        QCOMPARE(clock.time(), qint64(200000));
+    }
+};
+
+QTEST_GUILESS_MAIN(PlaybackClockTest)
+
+#include "playbackclocktest.moc"
@@ -0,0 +1,166 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QUrl>
+
+#include "probecache.h"
+
+using namespace Phonon::MPV;
+
+using Hints = QList<QPair<QByteArray, QByteArray>>;
+
+static QByteArray stream(int i) {
+    return QByteArrayLiteral("http://example.com/stream-") + QByteArray::number(i) + ".ts";
+}
+
+class ProbeCacheTest : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void hintsForRecordedDemuxer() {
+        ProbeCache cache;
+        QVERIFY(cache.hints(stream(0)).isEmpty());
+
+        cache.record(stream(0), "lavf", "mov,mp4,m4a,3gp,3g2,mj2");
+        const auto hints{cache.hints(stream(0))};
+        QVERIFY(hints.contains({"demuxer", "lavf"}));
+        QVERIFY(hints.contains({"demuxer-lavf-format", "mov"}));
+
+        cache.record(stream(1), "mkv", "matroska,webm");
+        QCOMPARE(cache.hints(stream(1)), Hints({{"demuxer", "mkv"}}));
+    }
+
+    void skipsWhatCanNotBeForced() {
+        ProbeCache cache;
+        cache.record(stream(0), "playlist", "hls");
+        cache.record(stream(1), "lavf", "");
+        cache.record("dvd://1", "lavf", "mpeg");
+        QVERIFY(cache.hints(stream(0)).isEmpty());
+        QVERIFY(cache.hints(stream(1)).isEmpty());
+        QVERIFY(cache.hints("dvd://1").isEmpty());
+    }
+
+    void forget() {
+        ProbeCache cache;
+        cache.record(stream(0), "mkv", "matroska,webm");
+        cache.forget(stream(0));
+        QVERIFY(cache.hints(stream(0)).isEmpty());
+    }
+
+    void dropsChangedFiles() {
+        QTemporaryDir dir;
+        QFile file{dir.filePath(QStringLiteral("clip.ts"))};
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("0123456789");
+        file.flush();
+        const auto mrl{QUrl::fromLocalFile(file.fileName()).toEncoded()};
+
+        ProbeCache cache;
+        cache.record(mrl, "lavf", "mpegts");
+        QVERIFY(!cache.hints(mrl).isEmpty());
+        file.write("0123456789");
+        file.close();
+        QVERIFY(cache.hints(mrl).isEmpty());
+        // Stays dropped although the file does not change anymore.
+        QVERIFY(cache.hints(mrl).isEmpty());
+    }
+
+    void saveAndLoad() {
+        QTemporaryDir dir;
+        const auto path{dir.filePath(QStringLiteral("probes"))};
+        {
+            ProbeCache cache;
+            cache.setBuild("build-a");
+            cache.record(stream(0), "lavf", "mpegts");
+            cache.record(stream(1), "mkv", "matroska,webm");
+            QVERIFY(cache.save(path));
+        }
+
+        ProbeCache cache;
+        QVERIFY(cache.load(path));
+        cache.setBuild("build-a");
+        QVERIFY(cache.hints(stream(0)).contains({"demuxer-lavf-format", "mpegts"}));
+        QCOMPARE(cache.hints(stream(1)), Hints({{"demuxer", "mkv"}}));
+        QVERIFY(cache.save(path));
+
+        // Another build may name its demuxers and formats differently.
+        QVERIFY(cache.load(path));
+        cache.setBuild("build-b");
+        QVERIFY(cache.hints(stream(0)).isEmpty());
+        QVERIFY(cache.hints(stream(1)).isEmpty());
+    }
+
+    void rejectsDamagedFiles() {
+        QTemporaryDir dir;
+        const auto path{dir.filePath(QStringLiteral("probes"))};
+        ProbeCache cache;
+        QVERIFY(!cache.load(path));
+
+        cache.record(stream(0), "lavf", "mpegts");
+        QVERIFY(cache.save(path));
+        QFile file{path};
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.resize(file.size() - 4));
+        file.close();
+
+        ProbeCache damaged;
+        damaged.record(stream(1), "mkv", "matroska,webm");
+        QVERIFY(!damaged.load(path));
+        // A failed load keeps what was there.
+        QCOMPARE(damaged.hints(stream(1)), Hints({{"demuxer", "mkv"}}));
+    }
+
+    void evictsLeastRecentlyUsed() {
+        QTemporaryDir dir;
+        const auto path{dir.filePath(QStringLiteral("probes"))};
+        // Entries are stamped with seconds, write a full cache with distinct ages instead of
+        // waiting for them to differ.
+        const auto capacity{4096};
+        {
+            QFile file{path};
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            QDataStream out{&file};
+            out << quint32(0x70687063) << quint32(2) << QByteArray("build") << qint32(capacity);
+            const auto now{QDateTime::currentSecsSinceEpoch()};
+            for(auto i{0}; i < capacity; i++) {
+                out << QCryptographicHash::hash(stream(i), QCryptographicHash::Sha1) << qint64(-1) << qint64(-1)
+                    << QByteArray("mkv") << QByteArray("matroska,webm") << qint64(now - capacity + i);
+            }
+        }
+
+        ProbeCache cache;
+        QVERIFY(cache.load(path));
+        cache.setBuild("build");
+        // Using the oldest entry makes the second oldest the one to go.
+        QVERIFY(!cache.hints(stream(0)).isEmpty());
+        cache.record(stream(capacity), "mkv", "matroska,webm");
+        QVERIFY(cache.hints(stream(1)).isEmpty());
+        QVERIFY(!cache.hints(stream(0)).isEmpty());
+        QVERIFY(!cache.hints(stream(2)).isEmpty());
+        QVERIFY(!cache.hints(stream(capacity)).isEmpty());
+    }
+};
+
+QTEST_GUILESS_MAIN(ProbeCacheTest)
+
+#include "probecachetest.moc"
@@ -0,0 +1,157 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QTest>
+
+#define MPV_ENABLE_DEPRECATED 0
+#include <mpv/client.h>
+
+#include <clocale>
+
+#include "requesttracker.h"
+
+// A core that plays nothing, replies are all the tests wait for
+static const struct {
+    const char* name;
+    const char* value;
+} CORE_OPTIONS[]{
+    {"config", "no"},
+    {"terminal", "no"},
+    {"load-scripts", "no"},
+    {"idle", "yes"},
+    {"vo", "null"},
+    {"ao", "null"},
+};
+
+using namespace Phonon::MPV;
+
+class RequestTrackerTest : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase() {
+        // libmpv refuses to run with another numeric locale.
+        setlocale(LC_NUMERIC, "C");
+        QVERIFY((m_core = mpv_create()));
+        for(const auto& option : CORE_OPTIONS)
+            QCOMPARE(mpv_set_option_string(m_core, option.name, option.value), 0);
+        QVERIFY(mpv_initialize(m_core) >= 0);
+    }
+
+    void cleanupTestCase() {
+        mpv_terminate_destroy(m_core);
+    }
+
+    void withoutHandle() {
+        RequestTracker tracker;
+        QCOMPARE(tracker.setProperty("volume", 50.0), quint64(0));
+        QCOMPARE(tracker.command(RequestTracker::CommandOperation, {"stop"}), quint64(0));
+        QVERIFY(!tracker.isWriting("volume"));
+        RequestTracker::Request request;
+        QVERIFY(!tracker.finish(1, &request));
+    }
+
+    void commandReply() {
+        RequestTracker tracker;
+        tracker.setHandle(m_core);
+        const auto id{tracker.command(RequestTracker::StopOperation, {"stop"})};
+        QVERIFY(id);
+        QCOMPARE(waitForReply(MPV_EVENT_COMMAND_REPLY), id);
+        RequestTracker::Request request;
+        QVERIFY(tracker.finish(id, &request));
+        QCOMPARE(request.operation, RequestTracker::StopOperation);
+        QCOMPARE(request.name, QByteArray("stop"));
+        // Each reply completes its request once.
+        QVERIFY(!tracker.finish(id, &request));
+    }
+
+    void coalescesWrites() {
+        RequestTracker tracker;
+        tracker.setHandle(m_core);
+        const auto first{tracker.setProperty("volume", 10.0)};
+        QVERIFY(first);
+        // Superseded writes ride on the one in flight.
+        QCOMPARE(tracker.setProperty("volume", 20.0), first);
+        QCOMPARE(tracker.setProperty("volume", 30.0), first);
+        QVERIFY(tracker.isWriting("volume"));
+        // Other properties are not held back.
+        const auto other{tracker.setProperty("mute", true)};
+        QVERIFY(other && other != first);
+
+        RequestTracker::Request request;
+        QCOMPARE(waitForReply(MPV_EVENT_SET_PROPERTY_REPLY), first);
+        QVERIFY(tracker.finish(first, &request));
+        QCOMPARE(request.operation, RequestTracker::PropertyOperation);
+        QCOMPARE(request.name, QByteArray("volume"));
+        // The latest value went out on completion of the first write.
+        QVERIFY(tracker.isWriting("volume"));
+        QCOMPARE(waitForReply(MPV_EVENT_SET_PROPERTY_REPLY), other);
+        QVERIFY(tracker.finish(other, &request));
+        QVERIFY(!tracker.isWriting("mute"));
+
+        const auto second{waitForReply(MPV_EVENT_SET_PROPERTY_REPLY)};
+        QVERIFY(second > other);
+        QVERIFY(tracker.finish(second, &request));
+        QVERIFY(!tracker.isWriting("volume"));
+
+        double volume{0};
+        QVERIFY(mpv_get_property(m_core, "volume", MPV_FORMAT_DOUBLE, &volume) >= 0);
+        QCOMPARE(volume, 30.0);
+    }
+
+    void failedWrite() {
+        RequestTracker tracker;
+        tracker.setHandle(m_core);
+        const auto id{tracker.setProperty("no-such-property", QByteArray("value"))};
+        QVERIFY(id);
+        QCOMPARE(waitForReply(MPV_EVENT_SET_PROPERTY_REPLY, MPV_ERROR_PROPERTY_NOT_FOUND), id);
+        RequestTracker::Request request;
+        QVERIFY(tracker.finish(id, &request));
+        QCOMPARE(request.name, QByteArray("no-such-property"));
+        QVERIFY(!tracker.isWriting("no-such-property"));
+    }
+
+    void setHandleDropsRequests() {
+        RequestTracker tracker;
+        tracker.setHandle(m_core);
+        const auto id{tracker.setProperty("volume", 40.0)};
+        QVERIFY(id);
+        tracker.setHandle(m_core);
+        QVERIFY(!tracker.isWriting("volume"));
+        QCOMPARE(waitForReply(MPV_EVENT_SET_PROPERTY_REPLY), id);
+        RequestTracker::Request request;
+        QVERIFY(!tracker.finish(id, &request));
+    }
+
+private:
+    /// \return The reply_userdata of the next \p id event, which must have failed with \p error.
+    quint64 waitForReply(mpv_event_id id, int error = 0) {
+        forever {
+            const auto event{mpv_wait_event(m_core, 5)};
+            if(event->event_id == MPV_EVENT_NONE)
+                return 0;
+            if(event->event_id == id)
+                return event->error == error ? event->reply_userdata : 0;
+        }
+    }
+
+    mpv_handle* m_core{nullptr};
+};
+
+QTEST_GUILESS_MAIN(RequestTrackerTest)
+
+#include "requesttrackertest.moc"
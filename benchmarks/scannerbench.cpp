@@ -0,0 +1,117 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+* Measures MediaScanner throughput for 1, 2, 4, ... workers up to one per CPU.
+*
+*   scannerbench [files] [seconds]
+*
+* Generates \a files clips of \a seconds with ffmpeg (sine tone and test pattern) in a
+* temporary directory and scans all of them once per worker count. Workers create their
+* cores during the run, so the numbers include core start-up like a first scan would.
+*/
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <QUrl>
+
+#include <atomic>
+#include <clocale>
+
+#include "mediascanner.h"
+
+using namespace Phonon::MPV;
+
+static bool generate(const QString& path, int seconds) {
+    const auto duration{QString::number(seconds)};
+    QProcess ffmpeg;
+    ffmpeg.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    ffmpeg.start(QStringLiteral("ffmpeg"), {
+        QStringLiteral("-v"), QStringLiteral("error"), QStringLiteral("-y"),
+        QStringLiteral("-f"), QStringLiteral("lavfi"), QStringLiteral("-i"), QStringLiteral("sine=frequency=440:duration=") + duration,
+        QStringLiteral("-f"), QStringLiteral("lavfi"), QStringLiteral("-i"), QStringLiteral("testsrc=size=320x240:rate=25:duration=") + duration,
+        QStringLiteral("-c:v"), QStringLiteral("mpeg4"), QStringLiteral("-c:a"), QStringLiteral("aac"),
+        QStringLiteral("-metadata"), QStringLiteral("title=scannerbench"),
+        QStringLiteral("-shortest"), path,
+    });
+    return ffmpeg.waitForFinished(-1) && ffmpeg.exitStatus() == QProcess::NormalExit && !ffmpeg.exitCode();
+}
+
+int main(int argc, char** argv) {
+    QCoreApplication app(argc, argv);
+    // libmpv parses numbers with the C locale.
+    setlocale(LC_NUMERIC, "C");
+    QTextStream out(stdout);
+
+    const auto args{app.arguments()};
+    const auto count{args.size() > 1 ? args.at(1).toInt() : 200};
+    const auto seconds{args.size() > 2 ? args.at(2).toInt() : 2};
+    if(count <= 0 || seconds <= 0) {
+        out << "usage: " << args.at(0) << " [files] [seconds]" << Qt::endl;
+        return 1;
+    }
+
+    QTemporaryDir dir;
+    const auto first{dir.filePath(QStringLiteral("clip-0.mkv"))};
+    if(!dir.isValid() || !generate(first, seconds)) {
+        out << "Failed to generate a clip, is ffmpeg installed?" << Qt::endl;
+        return 1;
+    }
+    // Copies are opened and demuxed like distinct files, encoding each is only slower.
+    QList<QUrl> urls{QUrl::fromLocalFile(first)};
+    for(auto i{1}; i < count; i++) {
+        const auto path{dir.filePath(QStringLiteral("clip-%1.mkv").arg(i))};
+        if(!QFile::copy(first, path)) {
+            out << "Failed to copy " << first << " to " << path << Qt::endl;
+            return 1;
+        }
+        urls.append(QUrl::fromLocalFile(path));
+    }
+
+    QList<int> threadCounts;
+    for(auto threads{1}; threads < QThread::idealThreadCount(); threads *= 2)
+        threadCounts.append(threads);
+    threadCounts.append(QThread::idealThreadCount());
+
+    out << count << " files of " << seconds << " s" << Qt::endl;
+    out << "threads\tfiles/s\tfailed" << Qt::endl;
+    for(const auto threads : qAsConst(threadCounts)) {
+        MediaScanner scanner(count, threads);
+        std::atomic<int> failed{0};
+        QObject::connect(&scanner, &MediaScanner::scanned, &scanner, [&failed](const QUrl&, const QVariantMap& result) {
+            if(result.contains(QStringLiteral("error")))
+                failed++;
+        }, Qt::DirectConnection);
+        QEventLoop loop;
+        QObject::connect(&scanner, &MediaScanner::finished, &loop, &QEventLoop::quit, Qt::QueuedConnection);
+
+        QElapsedTimer timer;
+        timer.start();
+        for(const auto& url : qAsConst(urls))
+            scanner.enqueue(url);
+        loop.exec();
+        const auto elapsed{timer.nsecsElapsed()};
+        out << threads << '\t' << QString::number(count * 1e9 / elapsed, 'f', 1) << '\t' << failed.load() << Qt::endl;
+    }
+    return 0;
+}
@@ -39,11 +39,15 @@ AudioOutput::AudioOutput(QObject* parent)
 }
 
 AudioOutput::~AudioOutput() {
+    // ~SinkNode can only reach its own handleDisconnectFromMediaObject(), release the properties here.
+    if(m_mediaObject)
+        disconnectFromMediaObject(m_mediaObject);
 }
 
 void AudioOutput::handleConnectToMediaObject(MediaObject* mediaObject) {
-    Q_UNUSED(mediaObject);
     setOutputDeviceImplementation();
+    mediaObject->attachProperty(MediaObject::MuteProperty);
+    mediaObject->attachProperty(MediaObject::VolumeProperty);
     if(!PulseSupport::getInstance()->isActive()) {
         // Rely on libmpv for updates if PASupport is not active
         connect(mediaObject, SIGNAL(mutedChanged(bool)),
@@ -56,6 +60,12 @@ void AudioOutput::handleConnectToMediaObject(MediaObject* mediaObject) {
         pulse->setupStreamEnvironment(m_streamUuid);
 }
 
+void AudioOutput::handleDisconnectFromMediaObject(MediaObject* mediaObject) {
+    disconnect(mediaObject, 0, this, 0);
+    mediaObject->detachProperty(MediaObject::MuteProperty);
+    mediaObject->detachProperty(MediaObject::VolumeProperty);
+}
+
 qreal AudioOutput::volume() const {
     return m_volume;
 }
@@ -68,9 +78,8 @@ void AudioOutput::setVolume(qreal volume) {
         double newVolume{m_volume * 100};
         if(newVolume > 100.f)
             newVolume = 100.f;
-        auto err{0};
-        if((err = mpv_set_property(m_player, "volume", MPV_FORMAT_DOUBLE, &newVolume)))
-            error() << "Failed to set volume:" << mpv_error_string(err);
+        // Writes superseded during a volume drag are coalesced by the tracker.
+        m_mediaObject->requests().setProperty("volume", newVolume);
 
         debug() << "Volume changed from" << preVolume << "to" << newVolume;
 
@@ -79,18 +88,16 @@ void AudioOutput::setVolume(qreal volume) {
 }
 
 void AudioOutput::setMuted(bool mute) {
-    auto err{0};
-    auto muted{0};
-    if((err = mpv_get_property(m_player, "mute", MPV_FORMAT_FLAG, &muted)))
-        warning() << "Failed to get volume:" << mpv_error_string(err);
-    if(mute == static_cast<bool>(muted)) {
+    if(!m_mediaObject) {
+        warning() << Q_FUNC_INFO << this << "no m_player set";
+        return;
+    }
+    if(mute == m_mediaObject->observed().mute) {
         // Make sure we actually have propagated the mutness into the frontend.
         onMutedChanged(mute);
         return;
     }
-    muted = mute;
-    if((err = mpv_set_property(m_player, "mute", MPV_FORMAT_FLAG, &muted)))
-        warning() << "Failed to set volume:" << mpv_error_string(err);
+    m_mediaObject->requests().setProperty("mute", mute);
 }
 
 void AudioOutput::setCategory(Category category) {
@@ -140,6 +147,8 @@ void AudioOutput::setOutputDeviceImplementation() {
         debug() << "Setting aout to pulse";
         if((err = mpv_set_property_string(m_player, "audio-device", "pulse")))
             warning() << "Failed to set pulse output:" << mpv_error_string(err);
+        else
+            m_mediaObject->setAudioDevice("pulse");
         return;
     }
 
@@ -164,6 +173,8 @@ void AudioOutput::setOutputDeviceImplementation() {
         debug() << "Setting output device to" << deviceName << '(' << m_device.property("name") << ')';
         if((err = mpv_set_property_string(m_player, "audio-device", soundSystem)))
             warning() << "Failed to set pulse output:" << mpv_error_string(err);
+        else
+            m_mediaObject->setAudioDevice(soundSystem);
     }
 }
 
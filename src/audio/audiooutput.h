@@ -56,6 +56,8 @@ namespace Phonon::MPV {
 
         /** \reimp */
         void handleConnectToMediaObject(MediaObject* mediaObject) Q_DECL_OVERRIDE;
+        /** \reimp */
+        void handleDisconnectFromMediaObject(MediaObject* mediaObject) Q_DECL_OVERRIDE;
 
         /**
         * \return The current volume for this audio output.
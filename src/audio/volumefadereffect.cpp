@@ -22,6 +22,7 @@
 #include <mpv/client.h>
 
 #include "utils/debug.h"
+#include "mediaobject.h"
 
 #include <QtCore/QTimeLine>
 
@@ -39,15 +40,22 @@ VolumeFaderEffect::VolumeFaderEffect(QObject *parent)
 }
 
 VolumeFaderEffect::~VolumeFaderEffect() {
+    // ~SinkNode can only reach its own handleDisconnectFromMediaObject(), release the properties here.
+    if(m_mediaObject)
+        disconnectFromMediaObject(m_mediaObject);
+}
+
+void VolumeFaderEffect::handleConnectToMediaObject(MediaObject* mediaObject) {
+    mediaObject->attachProperty(MediaObject::VolumeProperty);
+}
+
+void VolumeFaderEffect::handleDisconnectFromMediaObject(MediaObject* mediaObject) {
+    mediaObject->detachProperty(MediaObject::VolumeProperty);
 }
 
 float VolumeFaderEffect::volume() const {
-    Q_ASSERT(m_player);
-    double vol{0.0};
-    auto err{0};
-    if((err = mpv_get_property(m_player, "volume", MPV_FORMAT_DOUBLE, &vol)))
-        warning() << "Failed to get volume:" << mpv_error_string(err);
-    return vol / 100.0f;
+    Q_ASSERT(m_mediaObject);
+    return m_mediaObject->observed().volume / 100.0f;
 }
 
 void VolumeFaderEffect::slotSetVolume(qreal volume) {
@@ -107,13 +115,11 @@ void VolumeFaderEffect::abortFade() {
 
 void VolumeFaderEffect::setVolumeInternal(float v) {
     if (m_player) {
-        auto err{0};
         double volume{this->volume() * 100 * v};
         if(volume > 100.f)
             volume = 100.f;
         debug() << "Volume:" << volume;
-        if((err = mpv_set_property(m_player, "volume", MPV_FORMAT_DOUBLE, &volume)))
-            error() << "Failed to set volume:" << mpv_error_string(err);
+        m_mediaObject->requests().setProperty("volume", volume);
     } else {
         warning() << Q_FUNC_INFO << this << "no m_player set";
     }
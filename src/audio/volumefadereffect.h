@@ -46,6 +46,10 @@ namespace Phonon::MPV {
         void setVolume(float v) Q_DECL_OVERRIDE;
         QPointer<MediaObject> mediaObject() { return m_mediaObject; }
 
+    protected:
+        void handleConnectToMediaObject(MediaObject* mediaObject) Q_DECL_OVERRIDE;
+        void handleDisconnectFromMediaObject(MediaObject* mediaObject) Q_DECL_OVERRIDE;
+
     private Q_SLOTS:
         void slotSetVolume(qreal v);
 
@@ -24,11 +24,14 @@
 #include <QApplication>
 #include <QCoreApplication>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QMutexLocker>
 #include <QResizeEvent>
 #include <QIcon>
 #include <QMessageBox>
 #include <QtPlugin>
 #include <QSettings>
+#include <QThread>
 #include <QVariant>
 
 #include <phonon/GlobalDescriptionContainer>
@@ -38,24 +41,127 @@
 #include <mpv/client.h>
 
 #include <clocale>
+#include <cstring>
 
 #include "audio/audiooutput.h"
 #include "audio/audiodataoutput.h"
 #include "audio/volumefadereffect.h"
+#include "corepool.h"
+#include "devicecatalogue.h"
 #include "effect.h"
 #include "effectmanager.h"
+#include "eventdispatcher.h"
 #include "mediaobject.h"
+#include "mediascanner.h"
+#include "mimetypes.h"
 #include "sinknode.h"
+#include "utils/cache.h"
 #include "utils/debug.h"
+#include "utils/events.h"
 #include "video/videowidget.h"
+#include "waveformextractor.h"
+
+// Lead time of aboutToFinish() in milliseconds as long as no open latency was measured
+static const qint64 DEFAULT_ABOUT_TO_FINISH_LEAD = 2000;
+// Bounds of the adaptive lead, the lower one covers the round trip through libphonon
+static const qint64 MIN_ABOUT_TO_FINISH_LEAD = 500;
+static const qint64 MAX_ABOUT_TO_FINISH_LEAD = 20000;
+// Weight of a new sample in the rolling open latency estimate
+static const double OPEN_LATENCY_WEIGHT = 0.25;
+// Idle cores kept by the CorePool unless PHONON_MPV_POOL_SIZE says otherwise
+static const int DEFAULT_POOL_SIZE = 1;
+// Defaults of the mpv player that do nothing inside an application, applied before the user
+// config unless PHONON_MPV_EMBEDDED=0. Options unknown to older mpv versions are skipped.
+static const struct {
+    const char* name;
+    const char* value;
+} EMBEDDED_PROFILE[]{
+    {"config", "no"},
+    {"terminal", "no"},
+    {"load-scripts", "no"},
+    {"ytdl", "no"},
+    {"osc", "no"},
+    {"load-stats-overlay", "no"},
+    {"load-console", "no"},
+    {"load-auto-profiles", "no"},
+    {"input-default-bindings", "no"},
+    {"input-vo-keyboard", "no"},
+    {"resume-playback", "no"},
+};
+// Per-file options by URL scheme, MediaObject passes them with every loadfile.
+static const struct {
+    const char* scheme;
+    const char* name;
+    const char* value;
+} LOAD_PROFILES[]{
+    // Local files are read as needed, buffering ahead only costs memory.
+    {"file", "cache", "no"},
+    {"file", "demuxer-max-bytes", "16MiB"},
+    {"file", "demuxer-readahead-secs", "0"},
+    // Network streams ride out stalls with a deep buffer.
+    {"http", "cache", "yes"},
+    {"http", "demuxer-max-bytes", "256MiB"},
+    {"http", "demuxer-max-back-bytes", "64MiB"},
+    {"http", "demuxer-readahead-secs", "60"},
+    {"https", "cache", "yes"},
+    {"https", "demuxer-max-bytes", "256MiB"},
+    {"https", "demuxer-max-back-bytes", "64MiB"},
+    {"https", "demuxer-readahead-secs", "60"},
+    {"ftp", "cache", "yes"},
+    {"ftp", "demuxer-max-bytes", "256MiB"},
+    {"ftp", "demuxer-readahead-secs", "60"},
+    // Capture devices are live, every buffered frame is latency.
+    {"v4l2", "cache", "no"},
+    {"v4l2", "demuxer-readahead-secs", "0"},
+    {"v4l2", "demuxer-lavf-analyzeduration", "0.1"},
+    {"v4l2", "demuxer-lavf-o-add", "fflags=+nobuffer"},
+    {"v4l2", "video-latency-hacks", "yes"},
+    {"alsa", "cache", "no"},
+    {"alsa", "demuxer-readahead-secs", "0"},
+    {"alsa", "demuxer-lavf-analyzeduration", "0.1"},
+    {"screen", "cache", "no"},
+    {"screen", "demuxer-readahead-secs", "0"},
+    {"screen", "video-latency-hacks", "yes"},
+    // Drives spin down and seek slowly, read ahead at a quiet speed.
+    {"cdda", "cache", "yes"},
+    {"cdda", "cdda-speed", "4"},
+    {"cdda", "demuxer-readahead-secs", "20"},
+    {"dvd", "cache", "yes"},
+    {"dvd", "dvd-speed", "4"},
+    {"dvd", "demuxer-readahead-secs", "20"},
+    {"vcd", "cache", "yes"},
+    {"vcd", "demuxer-readahead-secs", "20"},
+    {"bluray", "cache", "yes"},
+    {"bluray", "demuxer-readahead-secs", "20"},
+};
 
 using namespace Phonon::MPV;
 
+// \return \p name without the action suffix of list options, option-info only knows base names.
+static QByteArray baseOptionName(const QByteArray& name) {
+    for(const auto suffix : {"-add", "-append", "-set", "-pre", "-remove", "-clr", "-toggle"}) {
+        if(name.endsWith(suffix))
+            return name.chopped(static_cast<int>(strlen(suffix)));
+    }
+    return name;
+}
+
+// \return The scheme of \p mrl, plain paths are files.
+static QByteArray schemeOf(const QByteArray& mrl) {
+    const auto end{mrl.indexOf("://")};
+    if(end <= 0)
+        return QByteArrayLiteral("file");
+    return mrl.left(end).toLower();
+}
+
 Backend* Backend::self;
 
 Backend::Backend(QObject* parent, const QVariantList&)
-    : QObject(parent), m_mpvInstance{nullptr}, m_effectManager{nullptr} {
+    : QObject(parent), m_mpvInstance{nullptr}, m_effectManager{nullptr}, m_dispatcher{nullptr}, m_corePool{nullptr}, m_scanner{nullptr}, m_waveforms{nullptr}
+    , m_client{nullptr}, m_drainPending{false}, m_warmupThread{nullptr}, m_coreInitialized{false}, m_coreInitBackground{false}, m_coreInitTime{0}, m_initialized{false}, m_initQueued{false} {
     self = this;
+    QElapsedTimer constructionTimer;
+    constructionTimer.start();
 
     // Backend information properties
     setProperty("identifier", QLatin1String("phonon_mpv"));
@@ -73,39 +179,85 @@ Backend::Backend(QObject* parent, const QVariantList&)
 
     debug() << "Constructing Phonon-MPV Version" << PHONON_MPV_VERSION;
 
+    m_dispatcher = new EventDispatcher(this);
+    m_dispatcher->start();
+
     std::setlocale(LC_NUMERIC, "C");
-    // Actual libMPV initialisation
-    if(!(m_mpvInstance = mpv_create())) {
-        fatal() << "libMPV: could not initialize";
-        return;
-    }
 
-    // Ends up as something like $HOME/.config/Phonon/mpv.conf
-    const auto configFileName{QSettings("Phonon", "mpv").fileName()};
-    auto err{0};
-    if(QFile::exists(configFileName)) {
-        if((err = mpv_load_config_file(m_mpvInstance, configFileName.toLocal8Bit().data())))
-            warning() << "Failed to apply config:" << mpv_error_string(err);
+    // Answers device queries until the devices are discovered.
+    m_devices.load(cacheFilePath(QStringLiteral("audio-devices")));
+    m_probes.load(cacheFilePath(QStringLiteral("probes")));
+
+    // Every MediaObject plays on a core of its own, the pool keeps some initialized ahead.
+    // It only starts creating cores once warmed up.
+    auto poolSize{DEFAULT_POOL_SIZE};
+    if(qEnvironmentVariableIsSet("PHONON_MPV_POOL_SIZE"))
+        poolSize = qEnvironmentVariableIntValue("PHONON_MPV_POOL_SIZE");
+    m_corePool = new CorePool([this] { return createCore(); }, poolSize);
+
+    // The core and the devices are set up on first use, apps that only query
+    // the backend never pay for them.
+    if(qgetenv("PHONON_MPV_WARMUP") == "1") {
+        m_warmupThread = QThread::create([this] {
+            initializeCore(true);
+            // The first MediaObject should find an idle core as well.
+            if(m_mpvInstance && qgetenv("PHONON_MPV_POOL_WARMUP") != "0")
+                m_corePool->warmUp();
+        });
+        m_warmupThread->start(QThread::LowPriority);
     }
+    debug() << "Backend constructed in" << constructionTimer.elapsed() << "ms, mpv initialization deferred";
+    //m_effectManager = new EffectManager(this);
+}
+
+void Backend::initializeCore(bool background) {
+    QMutexLocker locker(&m_initLock);
+    if(m_coreInitialized)
+        return;
+    QElapsedTimer timer;
+    timer.start();
 
+    // Actual libMPV initialisation
+    QByteArray logFile;
     if(qgetenv("PHONON_SUBSYSTEM_DEBUG").toInt() > 0) {
-        QByteArray input{"all=debug"};
-        if((err = mpv_set_option_string(m_mpvInstance, "msg-level", input.constData())))
-            warning() << "Failed to set Loglevel:" << mpv_error_string(err);
         QDir logFilePath{QDir::homePath().append("/.mpv")};
         logFilePath.mkdir("log");
-        const auto logFile{logFilePath.path()
+        logFile = logFilePath.path()
                 .append("/log/mpv-log-")
                 .append(QString::number(qApp->applicationPid()))
-                .append(".txt")};
-        if((err = mpv_set_option_string(m_mpvInstance, "log-file", logFile.toUtf8().constData())))
-            warning() << "Failed to set Logfile:" << mpv_error_string(err);
+                .append(".txt").toUtf8();
     }
-
-    // Create and initialize a libmpv instance (it should be done only once)
-    if (mpv_initialize(m_mpvInstance) >= 0) {
+    if((m_mpvInstance = createCore(logFile)))
         debug() << "Using MPV version" << mpv_client_api_version();
-    } else {
+    m_coreInitialized = true;
+    m_coreInitTime = timer.elapsed();
+    m_coreInitBackground = background;
+}
+
+void Backend::initializeForDevices() {
+    if(m_initialized)
+        return;
+    if(m_devices.isEmpty()) {
+        ensureInitialized();
+    } else if(!m_initQueued) {
+        // Answer from the cache, the discovery reports changes once it ran.
+        m_initQueued = true;
+        QMetaObject::invokeMethod(this, &Backend::ensureInitialized, Qt::QueuedConnection);
+    }
+}
+
+bool Backend::ensureInitialized() {
+    if(m_initialized)
+        return m_mpvInstance != nullptr;
+    m_initialized = true;
+    QElapsedTimer timer;
+    timer.start();
+
+    // Waits for a warmup still running in the background.
+    initializeCore(false);
+    if(m_warmupThread)
+        m_warmupThread->wait();
+    if(!m_mpvInstance) {
         QMessageBox msg;
         msg.setIcon(QMessageBox::Critical);
         msg.setWindowTitle(tr("LibMPV Failed to Initialize"));
@@ -115,81 +267,146 @@ Backend::Backend(QObject* parent, const QVariantList&)
         msg.setDetailedText("Failed to create and initialize MPV Core Instance");
         msg.exec();
         fatal() << "Phonon::MPV::mpvInit: Failed to initialize mpv";
+        return false;
     }
 
-    // until we have a video surface, disable video rendering
-    if((err = mpv_set_property_string(m_mpvInstance, "vo", "null")))
-        warning() << "failed to disable video rendering: " << mpv_error_string(err);
+    // Already running if the warmup thread got to it.
+    if(qgetenv("PHONON_MPV_POOL_WARMUP") != "0")
+        m_corePool->warmUp();
+
+    discoverDevices();
+    setupLoadProfiles();
+
+    // A rebuilt mpv or FFmpeg may keep the client API version of the cached MIME types.
+    const auto build{buildIdentifier(m_mpvInstance)};
+    if(!m_mimeTypesBuild.isEmpty() && m_mimeTypesBuild != build)
+        updateMimeTypes();
+    // Hints are only asked for by MediaObjects, which are created after this.
+    m_probes.setBuild(build);
+
+    // All of this used to run in the constructor.
+    const auto saved{timer.elapsed() + (m_coreInitBackground ? m_coreInitTime : 0)};
+    debug() << "Initialized on first use in" << timer.elapsed() << "ms, core" << m_coreInitTime << "ms"
+            << (m_coreInitBackground ? "in the background," : ",") << saved << "ms kept out of plugin load";
+    return true;
+}
+
+void Backend::discoverDevices() {
     PulseSupport* pulse{PulseSupport::getInstance()};
     pulse->enable(true);
     connect(pulse, SIGNAL(objectDescriptionChanged(ObjectDescriptionType)),
             SIGNAL(objectDescriptionChanged(ObjectDescriptionType)));
 
-    QList<QString> deviceList;
+    // Follow hotplugged devices through a client of the backend core.
+    QElapsedTimer timer;
+    timer.start();
+    if(!(m_client = mpv_create_client(m_mpvInstance, "devices"))) {
+        warning() << "Failed to create device client";
+    } else {
+        debug() << "First client created in" << timer.elapsed() << "ms";
+        requestEvents(m_client, {MPV_EVENT_PROPERTY_CHANGE});
+        mpv_observe_property(m_client, 0, "audio-device-list", MPV_FORMAT_NODE);
+        m_events.notify = Backend::event_cb;
+        m_events.opaque = this;
+        m_dispatcher->attach(m_client, &m_events);
+    }
+    refreshDevices();
+}
+
+void Backend::event_cb(void* opaque) {
+    Backend* that = reinterpret_cast<Backend*>(opaque);
+    // Called from the dispatcher thread, only post a drain if none is queued yet.
+    if(!that->m_drainPending.exchange(true))
+        QMetaObject::invokeMethod(that, &Backend::drainEvents, Qt::QueuedConnection);
+}
 
+void Backend::drainEvents() {
+    // Clear the flag first, batches arriving during the drain post a new one.
+    m_drainPending = false;
+    Event event;
+    auto changed{false};
+    while(m_events.events.pop(event))
+        changed |= event.id == MPV_EVENT_PROPERTY_CHANGE;
+    if(m_events.stalled)
+        m_dispatcher->resume();
+    if(changed)
+        refreshDevices();
+}
+
+void Backend::refreshDevices() {
+    auto err{0};
     mpv_node audioDevices;
     if((err = mpv_get_property(m_mpvInstance, "audio-device-list", MPV_FORMAT_NODE, &audioDevices))) {
         warning() << "Failed to get audio devices:" << mpv_error_string(err);
         return;
     }
 
-    QList<QByteArray> knownSoundSystems;
     // Whitelist - Order has no particular impact.
-    // NOTE: if listing was not intercepted by the PA code above we also need
-    //       to try injecting the pulse aout as otherwise the user would have to
-    //       use the fake PA device in ALSA to output through PA (kind of silly).
-    knownSoundSystems << QByteArray("pulse")
-                      << QByteArray("alsa")
-                      << QByteArray("oss")
-                      << QByteArray("jack");
-    QList<QByteArray> audioOutBackends;
+    static const QList<QByteArray> knownSoundSystems{"pulse", "alsa", "oss", "jack"};
+    QVector<DeviceCatalogue::Device> devices;
+    auto hasPulse{false};
     for(auto i{0}; i < audioDevices.u.list->num; i++) {
-        foreach(const auto &soundSystem, knownSoundSystems) {
-            if(QString(audioDevices.u.list->values[i].u.list->values[0].u.string).contains(soundSystem) && !audioOutBackends.contains(soundSystem))
-                audioOutBackends.append(soundSystem);
+        const auto& entry{audioDevices.u.list->values[i]};
+        QByteArray name;
+        QString description;
+        for(auto j{0}; j < entry.u.list->num; j++) {
+            if(!strcmp(entry.u.list->keys[j], "name"))
+                name = entry.u.list->values[j].u.string;
+            else if(!strcmp(entry.u.list->keys[j], "description"))
+                description = QString::fromUtf8(entry.u.list->values[j].u.string);
+        }
+        // Device names are <sound system>/<device>, "auto" picks the default output.
+        const auto soundSystem{name == "auto" ? name : name.left(name.indexOf('/'))};
+        hasPulse |= soundSystem == "pulse";
+        if(soundSystem != "auto" && !knownSoundSystems.contains(soundSystem)) {
+            debug() << "Sound system" << soundSystem << "not supported by libmpv";
+            continue;
+        }
+        if(soundSystem != "auto" && !name.contains('/')) {
+            // libmpv gives no devices for some sound systems, like OSS, and lists the bare
+            // sound system instead. Inject it without device, as the device list always did.
+            debug() << "manually injecting sound system" << soundSystem;
+            devices.append({QString::fromUtf8(soundSystem), description, DeviceAccess(soundSystem, QString())});
+            continue;
         }
+        devices.append({name == "auto" ? QStringLiteral("default") : QString::fromUtf8(name), description,
+                        DeviceAccess(soundSystem, QString::fromUtf8(name))});
     }
+    mpv_free_node_contents(&audioDevices);
 
+    PulseSupport* pulse{PulseSupport::getInstance()};
     if(pulse && pulse->isUsable()) {
-        if(audioOutBackends.contains("pulse")) {
-            m_devices.append(QPair<QString, DeviceAccess>("Default", DeviceAccess("pulse", "default")));
-            pulse->request(true);
-            return;
+        if(hasPulse) {
+            // PulseAudio manages the devices itself.
+            devices = {{QStringLiteral("Default"), QString(), DeviceAccess("pulse", "default")}};
+            if(!pulse->isActive())
+                pulse->request(true);
         } else {
             pulse->enable(false);
         }
     }
 
-    foreach(const QByteArray &soundSystem, knownSoundSystems) {
-        if(!audioOutBackends.contains(soundSystem)) {
-            debug() << "Sound system" << soundSystem << "not supported by libmpv";
-            continue;
-        }
-        const auto deviceCount{audioDevices.u.list->num};
-
-        for(auto i{0}; i < deviceCount; i++) {
-            QString idName(audioDevices.u.list->values[i].u.list->values[0].u.string);
-            debug() << "found device" << soundSystem << idName;
-            m_devices.append(QPair<QString, DeviceAccess>(idName == "auto" ? "default" : idName, DeviceAccess(soundSystem, idName)));
-            debug() << "Added backend device" << idName;
-        }
-
-        // libmpv gives no devices for some sound systems, like OSS
-        if(deviceCount == 0) {
-            debug() << "manually injecting sound system" << soundSystem;
-            // NOTE: Do not mark manually injected devices as advanced.
-            //       libphonon filters advanced devices from the default
-            //       selection which on systems such as OSX or Windows can
-            //       lead to an empty device list as the injected device is
-            //       the only available one.
-            m_devices.append(QPair<QString, DeviceAccess>(QString::fromUtf8(soundSystem), DeviceAccess(soundSystem, "")));
-        }
-    }
-    mpv_free_node_contents(&audioDevices);
-    //m_effectManager = new EffectManager(this);
+    if(!m_devices.update(devices))
+        return;
+    if(!m_devices.save(cacheFilePath(QStringLiteral("audio-devices"))))
+        warning() << "Failed to store the audio device cache";
+    emit objectDescriptionChanged(AudioOutputDeviceType);
 }
 
 Backend::~Backend() {
+    if(!m_probes.save(cacheFilePath(QStringLiteral("probes"))))
+        warning() << "Failed to store the probe cache";
+    if(m_client) {
+        m_dispatcher->detach(m_client);
+        mpv_destroy(m_client);
+    }
+    if(m_warmupThread) {
+        m_warmupThread->wait();
+        delete m_warmupThread;
+    }
+    delete m_corePool;
+    if(m_mpvInstance)
+        mpv_terminate_destroy(m_mpvInstance);
     if(GlobalAudioChannels::self)
         delete GlobalAudioChannels::self;
     if(GlobalSubtitles::self)
@@ -199,7 +416,7 @@ Backend::~Backend() {
 
 QObject* Backend::createObject(BackendInterface::Class c, QObject* parent, const QList<QVariant>& args) {
     Q_UNUSED(args)
-    if(!m_mpvInstance)
+    if(!ensureInitialized())
         return 0;
 
     switch(c) {
@@ -226,156 +443,46 @@ QObject* Backend::createObject(BackendInterface::Class c, QObject* parent, const
 }
 
 QStringList Backend::availableMimeTypes() const {
-    if(m_supportedMimeTypes.isEmpty())
-        const_cast<Backend*>(this)->m_supportedMimeTypes = QStringList{
-            "application/mpeg4-iod",
-            "application/mpeg4-muxcodetable",
-            "application/mxf",
-            "application/ogg",
-            "application/ram",
-            "application/sdp",
-            "application/vnd.apple.mpegurl",
-            "application/vnd.ms-asf",
-            "application/vnd.ms-wpl",
-            "application/vnd.rn-realmedia",
-            "application/vnd.rn-realmedia-vbr",
-            "application/x-cd-image",
-            "application/x-extension-m4a",
-            "application/x-extension-mp4",
-            "application/x-flac",
-            "application/x-flash-video",
-            "application/x-matroska",
-            "application/x-ogg",
-            "application/x-quicktime-media-link",
-            "application/x-quicktimeplayer",
-            "application/x-shockwave-flash",
-            "application/xspf+xml",
-            "audio/3gpp",
-            "audio/3gpp2",
-            "audio/AMR",
-            "audio/AMR-WB",
-            "audio/aac",
-            "audio/ac3",
-            "audio/basic",
-            "audio/dv",
-            "audio/eac3",
-            "audio/flac",
-            "audio/m4a",
-            "audio/midi",
-            "audio/mp1",
-            "audio/mp2",
-            "audio/mp3",
-            "audio/mp4",
-            "audio/mpeg",
-            "audio/mpegurl",
-            "audio/mpg",
-            "audio/ogg",
-            "audio/opus",
-            "audio/scpls",
-            "audio/vnd.dolby.heaac.1",
-            "audio/vnd.dolby.heaac.2",
-            "audio/vnd.dolby.mlp",
-            "audio/vnd.dts",
-            "audio/vnd.dts.hd",
-            "audio/vnd.rn-realaudio",
-            "audio/vorbis",
-            "audio/wav",
-            "audio/webm",
-            "audio/x-aac",
-            "audio/x-adpcm",
-            "audio/x-aiff",
-            "audio/x-ape",
-            "audio/x-flac",
-            "audio/x-gsm",
-            "audio/x-it",
-            "audio/x-m4a",
-            "audio/x-matroska",
-            "audio/x-mod",
-            "audio/x-mp1",
-            "audio/x-mp2",
-            "audio/x-mp3",
-            "audio/x-mpeg",
-            "audio/x-mpegurl",
-            "audio/x-mpg",
-            "audio/x-ms-asf",
-            "audio/x-ms-asx",
-            "audio/x-ms-wax",
-            "audio/x-ms-wma",
-            "audio/x-musepack",
-            "audio/x-pn-aiff",
-            "audio/x-pn-au",
-            "audio/x-pn-realaudio",
-            "audio/x-pn-realaudio-plugin",
-            "audio/x-pn-wav",
-            "audio/x-pn-windows-acm",
-            "audio/x-real-audio",
-            "audio/x-realaudio",
-            "audio/x-s3m",
-            "audio/x-scpls",
-            "audio/x-shorten",
-            "audio/x-speex",
-            "audio/x-tta",
-            "audio/x-vorbis",
-            "audio/x-vorbis+ogg",
-            "audio/x-wav",
-            "audio/x-wavpack",
-            "audio/x-xm",
-            "image/vnd.rn-realpix",
-            "misc/ultravox",
-            "text/google-video-pointer",
-            "text/x-google-video-pointer",
-            "video/3gp",
-            "video/3gpp",
-            "video/3gpp2",
-            "video/avi",
-            "video/divx",
-            "video/dv",
-            "video/fli",
-            "video/flv",
-            "video/mp2t",
-            "video/mp4",
-            "video/mp4v-es",
-            "video/mpeg",
-            "video/mpeg-system",
-            "video/msvideo",
-            "video/ogg",
-            "video/quicktime",
-            "video/vnd.divx",
-            "video/vnd.mpegurl",
-            "video/vnd.rn-realvideo",
-            "video/webm",
-            "video/x-anim",
-            "video/x-avi",
-            "video/x-flc",
-            "video/x-fli",
-            "video/x-flv",
-            "video/x-m4v",
-            "video/x-matroska",
-            "video/x-mpeg",
-            "video/x-mpeg-system",
-            "video/x-mpeg2",
-            "video/x-ms-asf",
-            "video/x-ms-asf-plugin",
-            "video/x-ms-asx",
-            "video/x-ms-wm",
-            "video/x-ms-wmv",
-            "video/x-ms-wmx",
-            "video/x-ms-wvx",
-            "video/x-msvideo",
-            "video/x-nsv",
-            "video/x-ogm",
-            "video/x-ogm+ogg",
-            "video/x-theora",
-            "video/x-theora+ogg",
-            "x-content/audio-cdda",
-            "x-content/audio-player",
-            "x-content/video-dvd",
-            "x-content/video-svcd",
-            "x-content/video-vcd",
-        };
+    if(!m_supportedMimeTypes.isEmpty())
+        return m_supportedMimeTypes;
+
+    // The demuxers only change with libmpv, answer from disk without starting a core.
+    MimeTypeCache cache;
+    if(cache.load(cacheFilePath("mimetypes")) && cache.apiVersion == mpv_client_api_version()) {
+        self->m_supportedMimeTypes = cache.types;
+        self->m_mimeTypesBuild = cache.build;
+        return m_supportedMimeTypes;
+    }
+
+    // First launch with this libmpv, a bare core is enough to ask.
+    self->initializeCore(false);
+    if(m_mpvInstance)
+        self->updateMimeTypes();
     return m_supportedMimeTypes;
 }
 
+void Backend::updateMimeTypes() {
+    QElapsedTimer timer;
+    timer.start();
+    MimeTypeCache cache;
+    cache.apiVersion = mpv_client_api_version();
+    cache.build = buildIdentifier(m_mpvInstance);
+    cache.types = probeMimeTypes(m_mpvInstance);
+    if(cache.types.isEmpty()) {
+        warning() << "Failed to probe MIME types, assuming all known ones";
+        if(m_supportedMimeTypes.isEmpty())
+            m_supportedMimeTypes = knownMimeTypes();
+        return;
+    }
+    if(!cache.save(cacheFilePath("mimetypes")))
+        warning() << "Failed to store the MIME types";
+    if(!m_supportedMimeTypes.isEmpty() && cache.types != m_supportedMimeTypes)
+        debug() << "MIME types changed with" << cache.build;
+    m_supportedMimeTypes = cache.types;
+    m_mimeTypesBuild = cache.build;
+    debug() << "Probed" << m_supportedMimeTypes.size() << "MIME types in" << timer.elapsed() << "ms";
+}
+
 QList<int> Backend::objectDescriptionIndexes(ObjectDescriptionType type) const {
     QList<int> list;
 
@@ -386,10 +493,8 @@ QList<int> Backend::objectDescriptionIndexes(ObjectDescriptionType type) const {
         case Phonon::AudioOutputDeviceType:
         case Phonon::AudioCaptureDeviceType:
         case Phonon::VideoCaptureDeviceType: {
-            QList<int> ids;
-            for(auto i{0}; i < m_devices.size(); i++)
-                    ids.append(i);
-            return ids;
+            self->initializeForDevices();
+            return m_devices.indexes();
         }
         break;
         case Phonon::EffectType: /*{
@@ -419,13 +524,22 @@ QHash<QByteArray, QVariant> Backend::objectDescriptionProperties(ObjectDescripti
         case Phonon::AudioOutputDeviceType:
         case Phonon::AudioCaptureDeviceType:
         case Phonon::VideoCaptureDeviceType: {
+            self->initializeForDevices();
+            const auto device{m_devices.device(index)};
+            if(!device)
+                break;
             // Index should be unique, even for different categories
             QHash<QByteArray, QVariant> properties;
-            properties.insert("name", m_devices[index].first);
-            properties.insert("description", "Detected MPV Device");
-            properties.insert("isAdvanced", m_devices[index].first == "default" ? false : true);
+            properties.insert("name", device->name);
+            properties.insert("description", device->description.isEmpty() ? QStringLiteral("Detected MPV Device") : device->description);
+            // NOTE: Do not mark manually injected devices as advanced.
+            //       libphonon filters advanced devices from the default
+            //       selection which on systems such as OSX or Windows can
+            //       lead to an empty device list as the injected device is
+            //       the only available one.
+            properties.insert("isAdvanced", device->name != "default" && !device->access.second.isEmpty());
             DeviceAccessList list;
-            list.append(m_devices[index].second);
+            list.append(device->access);
             properties.insert("deviceAccessList", QVariant::fromValue<Phonon::DeviceAccessList>(list));
             properties.insert("discovererIcon", "mpv");
             properties.insert("icon", QLatin1String("audio-card"));
@@ -520,3 +634,154 @@ EffectManager* Backend::effectManager() const {
     //return m_effectManager;
     return NULL;
 }
+
+EventDispatcher* Backend::dispatcher() const {
+    return m_dispatcher;
+}
+
+CorePool* Backend::corePool() const {
+    return m_corePool;
+}
+
+QObject* Backend::mediaScanner() {
+    // Scanning cores are independent of the backend core, no initialization needed.
+    if(!m_scanner)
+        m_scanner = new MediaScanner(1024, qEnvironmentVariableIntValue("PHONON_MPV_SCANNER_THREADS"), this);
+    return m_scanner;
+}
+
+QObject* Backend::waveformExtractor() {
+    if(!m_waveforms)
+        m_waveforms = new WaveformExtractor(this);
+    return m_waveforms;
+}
+
+quint64 Backend::corePoolHits() const {
+    return m_corePool->hits();
+}
+
+quint64 Backend::corePoolMisses() const {
+    return m_corePool->misses();
+}
+
+mpv_handle* Backend::createCore(const QByteArray& logFile) const {
+    QElapsedTimer timer;
+    timer.start();
+    mpv_handle* core{nullptr};
+    if(!(core = mpv_create())) {
+        error() << "libMPV: could not create core";
+        return nullptr;
+    }
+    const auto created{timer.restart()};
+    auto err{0};
+
+    if(qgetenv("PHONON_MPV_EMBEDDED") != "0") {
+        for(const auto& option : EMBEDDED_PROFILE) {
+            if((err = mpv_set_option_string(core, option.name, option.value)))
+                debug() << "Skipping embedded option" << option.name << ":" << mpv_error_string(err);
+        }
+    }
+
+    // Sources queued by setNextSource() are demuxed ahead and played without gap,
+    // the user config below may still override this.
+    if((err = mpv_set_option_string(core, "prefetch-playlist", "yes")))
+        warning() << "Failed to enable playlist prefetching:" << mpv_error_string(err);
+    if((err = mpv_set_option_string(core, "gapless-audio", "yes")))
+        warning() << "Failed to enable gapless audio:" << mpv_error_string(err);
+
+    auto options{timer.restart()};
+    // Ends up as something like $HOME/.config/Phonon/mpv.conf, it may override the profile above
+    const auto configFileName{QSettings("Phonon", "mpv").fileName()};
+    if(QFile::exists(configFileName)) {
+        if((err = mpv_load_config_file(core, configFileName.toLocal8Bit().data())))
+            warning() << "Failed to apply config:" << mpv_error_string(err);
+    }
+    const auto config{timer.restart()};
+
+    // until we have a video surface, disable video rendering
+    if((err = mpv_set_option_string(core, "vo", "null")))
+        warning() << "failed to disable video rendering: " << mpv_error_string(err);
+
+    if(qgetenv("PHONON_SUBSYSTEM_DEBUG").toInt() > 0) {
+        QByteArray input{"all=debug"};
+        if((err = mpv_set_option_string(core, "msg-level", input.constData())))
+            warning() << "Failed to set Loglevel:" << mpv_error_string(err);
+    }
+    if(!logFile.isEmpty()) {
+        if((err = mpv_set_option_string(core, "log-file", logFile.constData())))
+            warning() << "Failed to set Logfile:" << mpv_error_string(err);
+    }
+    options += timer.restart();
+
+    if((err = mpv_initialize(core)) < 0) {
+        error() << "Failed to initialize MPV core:" << mpv_error_string(err);
+        mpv_terminate_destroy(core);
+        return nullptr;
+    }
+    debug() << "Core started in" << created + options + config + timer.elapsed() << "ms: create" << created
+            << "ms, options" << options << "ms, config" << config << "ms, initialize" << timer.elapsed() << "ms";
+    // The handle only owns the core, players use clients of it and nobody reads its events.
+    requestEvents(core, {});
+    return core;
+}
+
+void Backend::recordOpenLatency(const QByteArray& mrl, qint64 msecs) {
+    const auto scheme{schemeOf(mrl)};
+    auto it{m_openLatency.find(scheme)};
+    if(it == m_openLatency.end())
+        it = m_openLatency.insert(scheme, msecs);
+    else
+        *it += OPEN_LATENCY_WEIGHT * (msecs - *it);
+    debug() << "open latency of" << scheme << msecs << "ms, estimate" << *it << "ms";
+}
+
+void Backend::setupLoadProfiles() {
+    // Unknown options would fail the whole loadfile, e.g. cdda-speed without libcdio.
+    for(const auto& option : LOAD_PROFILES) {
+        const auto property{QByteArray("option-info/").append(baseOptionName(option.name)).append("/name")};
+        char* info{nullptr};
+        if(!(info = mpv_get_property_string(m_mpvInstance, property.constData()))) {
+            debug() << "Skipping load option" << option.name << "for" << option.scheme;
+            continue;
+        }
+        mpv_free(info);
+        m_loadProfiles[option.scheme].append({option.name, option.value});
+    }
+
+    // Users tune the profiles from mpv.conf, e.g. [phonon-http] with demuxer-max-bytes=1GiB.
+    mpv_node profiles;
+    if(mpv_get_property(m_mpvInstance, "profile-list", MPV_FORMAT_NODE, &profiles) < 0)
+        return;
+    if(profiles.format == MPV_FORMAT_NODE_ARRAY) {
+        for(auto i{0}; i < profiles.u.list->num; i++) {
+            const auto& profile{profiles.u.list->values[i]};
+            if(profile.format != MPV_FORMAT_NODE_MAP)
+                continue;
+            for(auto j{0}; j < profile.u.list->num; j++) {
+                if(strcmp(profile.u.list->keys[j], "name") || profile.u.list->values[j].format != MPV_FORMAT_STRING)
+                    continue;
+                const QByteArray name{profile.u.list->values[j].u.string};
+                if(name.startsWith("phonon-")) {
+                    debug() << "Using profile" << name;
+                    m_loadProfiles[name.mid(7)].append({"profile", name});
+                }
+            }
+        }
+    }
+    mpv_free_node_contents(&profiles);
+}
+
+QList<QPair<QByteArray, QByteArray>> Backend::loadOptions(const QByteArray& mrl) const {
+    return m_loadProfiles.value(schemeOf(mrl));
+}
+
+qint64 Backend::aboutToFinishLead(const QByteArray& mrl) const {
+    if(mrl.isEmpty())
+        return DEFAULT_ABOUT_TO_FINISH_LEAD;
+    const auto it{m_openLatency.constFind(schemeOf(mrl))};
+    if(it == m_openLatency.constEnd())
+        return DEFAULT_ABOUT_TO_FINISH_LEAD;
+    // Twice the estimate leaves room for outliers above the average.
+    return qBound(MIN_ABOUT_TO_FINISH_LEAD, MIN_ABOUT_TO_FINISH_LEAD + static_cast<qint64>(2 * *it),
+                  MAX_ABOUT_TO_FINISH_LEAD);
+}
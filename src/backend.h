@@ -22,17 +22,31 @@
 #ifndef Phonon_MPV_BACKEND_H
 #define Phonon_MPV_BACKEND_H
 
+#include <QHash>
+#include <QMutex>
+#include <QPair>
 #include <QStringList>
 
+#include <atomic>
+
 #include <phonon/objectdescription.h>
 #include <phonon/backendinterface.h>
 
+#include "devicecatalogue.h"
+#include "eventdispatcher.h"
+#include "probecache.h"
+
+class QThread;
 struct mpv_handle;
 class LibMPV;
 
 namespace Phonon::MPV {
+    class CorePool;
     class DeviceManager;
     class EffectManager;
+    class EventDispatcher;
+    class MediaScanner;
+    class WaveformExtractor;
 
     /** \brief Backend class for Phonon-MPV.
     *
@@ -52,6 +66,10 @@ namespace Phonon::MPV {
         Q_OBJECT
         Q_PLUGIN_METADATA(IID "org.kde.phonon.mpv" FILE "phonon-mpv.json")
         Q_INTERFACES(Phonon::BackendInterface)
+        /// Acquired cores that were taken from the idle pool
+        Q_PROPERTY(quint64 corePoolHits READ corePoolHits)
+        /// Acquired cores that had to be created on demand
+        Q_PROPERTY(quint64 corePoolMisses READ corePoolMisses)
 
     public:
         /**
@@ -61,9 +79,9 @@ namespace Phonon::MPV {
         static Backend* self;
 
         /**
-        * Constructs the backend. Sets the backend properties, fetches the debug level from the
-        * environment, initializes libVLC, constructs the device and effect managers, initializes
-        * PulseAudio support.
+        * Constructs the backend. Sets the backend properties and fetches the debug level from the
+        * environment. libmpv, the devices and PulseAudio support are initialized on first use,
+        * see ensureInitialized().
         *
         * \param parent A parent object for the backend (passed to the QObject constructor)
         */
@@ -73,9 +91,70 @@ namespace Phonon::MPV {
         /// \return The mpv handle that is associated with this backend object
         mpv_handle* handle() const;
 
+        /**
+        * Initializes the core, the CorePool and the device list on first use, plugin load
+        * only sets up the backend object. With PHONON_MPV_WARMUP=1 the core is initialized
+        * and the CorePool warmed up on a background thread right after load.
+        * \return \c false if mpv failed to initialize.
+        */
+        bool ensureInitialized();
+
         /// \return The effect manager that is associated with this backend object.
         EffectManager* effectManager() const;
 
+        /// \return The thread dispatching the events of all mpv clients.
+        EventDispatcher* dispatcher() const;
+
+        /**
+        * \return The pool handing out the cores of MediaObjects. Its size is set by
+        * PHONON_MPV_POOL_SIZE, PHONON_MPV_POOL_WARMUP=0 disables creating cores ahead.
+        */
+        CorePool* corePool() const;
+
+        /// \return The demuxers detected for previously opened sources, stored on exit.
+        inline ProbeCache& probeCache() { return m_probes; }
+
+        /**
+        * \return The scanner reading tags, duration and streams of files in parallel, created
+        * on first use. Applications call it through QMetaObject::invokeMethod() on the backend.
+        * PHONON_MPV_SCANNER_THREADS sets its amount of workers, one per CPU by default.
+        */
+        Q_INVOKABLE QObject* mediaScanner();
+
+        /// \return The extractor of seek bar envelopes, created on first use, see mediaScanner().
+        Q_INVOKABLE QObject* waveformExtractor();
+
+        quint64 corePoolHits() const;
+        quint64 corePoolMisses() const;
+
+        /**
+        * Creates and initializes a core with the backend options and the user config applied.
+        * Thread safe, the CorePool calls it from its worker.
+        * \param logFile Log file of the core, none if empty.
+        */
+        mpv_handle* createCore(const QByteArray& logFile = QByteArray()) const;
+
+        /**
+        * Adds a measured open latency, from loadfile to the first playback restart, of \p mrl to
+        * the rolling estimate of its scheme.
+        */
+        void recordOpenLatency(const QByteArray& mrl, qint64 msecs);
+
+        /**
+        * \return How long before the end of \p mrl aboutToFinish() should be emitted, so the
+        * next source of the same scheme is opened in time. Derived from the open latency estimate
+        * of the scheme, a fixed default is used until a latency was measured and for an empty
+        * \p mrl, i.e. an unknown next source.
+        */
+        qint64 aboutToFinishLead(const QByteArray& mrl) const;
+
+        /**
+        * \return The per-file loadfile options for \p mrl, picked by its scheme: small caches for
+        * local files, deep readahead for network streams, low latency for capture devices and
+        * drive settings for discs. A profile [phonon-<scheme>] in the user config is applied last.
+        */
+        QList<QPair<QByteArray, QByteArray>> loadOptions(const QByteArray& mrl) const;
+
         /**
         * Creates a backend object of the desired class and with the desired parent. Extra arguments can be provided.
         *
@@ -143,12 +222,63 @@ namespace Phonon::MPV {
         void objectDescriptionChanged(ObjectDescriptionType);
 
     private:
+        /// Creates m_mpvInstance once, from ensureInitialized() or the warmup thread.
+        void initializeCore(bool background);
+
+        /// Sets up PulseAudio support and starts following the audio devices of m_mpvInstance.
+        void discoverDevices();
+
+        /// Diffs audio-device-list into m_devices, reports and stores real changes.
+        void refreshDevices();
+
+        /**
+        * Initializes before a device query. If cached devices are known they answer the query
+        * and the initialization runs from the event loop.
+        */
+        void initializeForDevices();
+
+        /// Fills m_loadProfiles with the options of LOAD_PROFILES that m_mpvInstance knows.
+        void setupLoadProfiles();
+
+        /// Probes m_mpvInstance for the supported MIME types and stores them on disk.
+        void updateMimeTypes();
+
+        static void event_cb(void* opaque);
+        /// Drains the events of m_client, i.e. audio-device-list changes.
+        void drainEvents();
+
         QStringList m_supportedMimeTypes;
+        /// buildIdentifier() of the core m_supportedMimeTypes were probed on
+        QByteArray m_mimeTypesBuild;
         mpv_handle* m_mpvInstance;
         
-        QVector<QPair<QString, DeviceAccess>> m_devices;
+        DeviceCatalogue m_devices;
+        ProbeCache m_probes;
+        /// Client of m_mpvInstance observing audio-device-list
+        mpv_handle* m_client;
+        EventQueue m_events;
+        /// A drainEvents() call is queued
+        std::atomic<bool> m_drainPending;
 
         EffectManager* m_effectManager;
+        EventDispatcher* m_dispatcher;
+        CorePool* m_corePool;
+        MediaScanner* m_scanner;
+        WaveformExtractor* m_waveforms;
+
+        QThread* m_warmupThread;
+        /// Guards the initialization of m_mpvInstance against the warmup thread
+        QMutex m_initLock;
+        bool m_coreInitialized;
+        bool m_coreInitBackground;
+        qint64 m_coreInitTime;
+        bool m_initialized;
+        bool m_initQueued;
+
+        /// Rolling open latency estimate in ms per URL scheme
+        QHash<QByteArray, double> m_openLatency;
+        /// Per-file options by scheme, see loadOptions()
+        QHash<QByteArray, QList<QPair<QByteArray, QByteArray>>> m_loadProfiles;
     };
 } // namespace Phonon::MPV
 
@@ -0,0 +1,171 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "corepool.h"
+
+#include <QMutexLocker>
+
+#define MPV_ENABLE_DEPRECATED 0
+#include <mpv/client.h>
+
+#include "utils/debug.h"
+
+// Properties MediaObject and its sinks change at runtime, with the value of a fresh core.
+// Per-file options restore themselves when the file ends.
+static const char* const RESET_PROPERTIES[][2]{
+    {"pause", "no"},
+    {"vo", "null"},
+    {"vid", "auto"},
+    {"aid", "auto"},
+    {"sid", "auto"},
+    {"sub-auto", "exact"},
+    {"volume", "100"},
+    {"mute", "no"},
+    {"speed", "1"},
+    {"audio-device", "auto"},
+    {"brightness", "0"},
+    {"contrast", "0"},
+    {"hue", "0"},
+    {"saturation", "0"},
+    {"video-aspect-override", "-1"},
+};
+
+// Options shared by all headless cores, see createHeadlessCore()
+static const Phonon::MPV::CoreOption HEADLESS_OPTIONS[]{
+    {"config", "no"},
+    {"terminal", "no"},
+    {"load-scripts", "no"},
+    {"ytdl", "no"},
+    {"idle", "yes"},
+    {"vo", "null"},
+    {"ao", "null"},
+    {"sid", "no"},
+    {"audio-display", "no"},
+};
+
+using namespace Phonon::MPV;
+
+mpv_handle* Phonon::MPV::createHeadlessCore(const char* purpose, std::initializer_list<CoreOption> options) {
+    mpv_handle* core{nullptr};
+    if(!(core = mpv_create())) {
+        error() << "libMPV: could not create" << purpose << "core";
+        return nullptr;
+    }
+    auto err{0};
+    for(const auto& option : HEADLESS_OPTIONS) {
+        if((err = mpv_set_option_string(core, option.name, option.value)))
+            debug() << "Skipping" << purpose << "option" << option.name << ":" << mpv_error_string(err);
+    }
+    for(const auto& option : options) {
+        if((err = mpv_set_option_string(core, option.name, option.value)))
+            debug() << "Skipping" << purpose << "option" << option.name << ":" << mpv_error_string(err);
+    }
+    if((err = mpv_initialize(core)) < 0) {
+        error() << "Failed to initialize" << purpose << "core:" << mpv_error_string(err);
+        mpv_terminate_destroy(core);
+        return nullptr;
+    }
+    return core;
+}
+
+CorePool::CorePool(Factory factory, int size)
+    : m_factory(std::move(factory))
+    , m_size(qMax(0, size))
+    , m_warming(0)
+    , m_hits(0)
+    , m_misses(0) {
+    m_workers.setMaxThreadCount(1);
+    m_reaper.setMaxThreadCount(1);
+}
+
+CorePool::~CorePool() {
+    m_reaper.waitForDone();
+    m_workers.waitForDone();
+    for(auto core : qAsConst(m_idle))
+        mpv_terminate_destroy(core);
+}
+
+void CorePool::warmUp() {
+    QMutexLocker locker(&m_lock);
+    for(; m_idle.size() + m_warming < m_size; m_warming++) {
+        m_workers.start([this] {
+            auto core{m_factory()};
+            QMutexLocker locker(&m_lock);
+            m_warming--;
+            if(core && m_idle.size() < m_size) {
+                m_idle.append(core);
+                core = nullptr;
+            }
+            locker.unlock();
+            if(core)
+                mpv_terminate_destroy(core);
+        });
+    }
+}
+
+mpv_handle* CorePool::acquire() {
+    mpv_handle* core{nullptr};
+    {
+        QMutexLocker locker(&m_lock);
+        if(!m_idle.isEmpty())
+            core = m_idle.takeFirst();
+    }
+    if(core) {
+        m_hits++;
+    } else {
+        m_misses++;
+        core = m_factory();
+    }
+    debug() << "core pool hits:" << m_hits << "misses:" << m_misses;
+    // Top up for the next player.
+    warmUp();
+    return core;
+}
+
+void CorePool::release(mpv_handle* core, mpv_handle* client) {
+    if(!core)
+        return;
+    m_reaper.start([this, core, client] { reap(core, client); });
+}
+
+void CorePool::reap(mpv_handle* core, mpv_handle* client) {
+    if(client)
+        mpv_destroy(client);
+    if(reset(core)) {
+        QMutexLocker locker(&m_lock);
+        if(m_idle.size() < m_size) {
+            m_idle.append(core);
+            return;
+        }
+    }
+    mpv_terminate_destroy(core);
+}
+
+bool CorePool::reset(mpv_handle* core) {
+    const char* stop[]{"stop", nullptr};
+    auto err{0};
+    if((err = mpv_command(core, stop))) {
+        warning() << "Failed to stop pooled core:" << mpv_error_string(err);
+        return false;
+    }
+    for(const auto& property : RESET_PROPERTIES) {
+        // Properties unknown to the mpv version are fine to fail.
+        if((err = mpv_set_property_string(core, property[0], property[1])))
+            debug() << "Failed to reset" << property[0] << ":" << mpv_error_string(err);
+    }
+    return true;
+}
@@ -0,0 +1,112 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_MPV_COREPOOL_H
+#define PHONON_MPV_COREPOOL_H
+
+#include <QList>
+#include <QMutex>
+#include <QThreadPool>
+
+#include <atomic>
+#include <functional>
+#include <initializer_list>
+
+struct mpv_handle;
+
+namespace Phonon::MPV {
+
+    struct CoreOption {
+        const char* name;
+        const char* value;
+    };
+
+    /**
+    * Creates and initializes a core for background work that never plays to the user: no
+    * user config, scripts or terminal, idle, no video or audio output and no subtitles.
+    * \p options are set afterwards and may override these, \p purpose names the core in logs.
+    * \return The core, \c nullptr if it could not be created or initialized.
+    */
+    mpv_handle* createHeadlessCore(const char* purpose, std::initializer_list<CoreOption> options);
+
+    /** \brief Pool of initialized, idle mpv cores
+    *
+    * Every MediaObject plays on a core of its own, so players do not share playlist and
+    * playback state. Creating and initializing a core is slow, the pool keeps a few of them
+    * ready and takes cores back once their player is gone.
+    * Owners of a core only use clients of it (mpv_create_client()), the handle of the core
+    * itself has all events disabled and is never drained.
+    *
+    * Shutting a core down blocks until its demuxer, decoder and audio threads are gone, so
+    * returned cores are reset or destroyed on a reaper thread instead of the caller's thread.
+    */
+    class CorePool {
+    public:
+        using Factory = std::function<mpv_handle*()>;
+
+        /// \p factory creates and initializes a core, \p size cores are kept idle at most.
+        CorePool(Factory factory, int size);
+        ~CorePool();
+
+        /// Creates cores on a worker thread until \p size cores are idle.
+        void warmUp();
+
+        /**
+        * \return An idle core, a newly created one if none is idle (a miss). The caller owns the
+        * core until it is handed back with release(). \c nullptr if no core could be created.
+        */
+        mpv_handle* acquire();
+
+        /**
+        * Takes \p core back together with the \p client its owner used and returns at once.
+        * On the reaper thread the client is destroyed and the core is stopped and reset to the
+        * defaults a MediaObject expects. Cores that can not be reset or do not fit into the pool
+        * are destroyed.
+        */
+        void release(mpv_handle* core, mpv_handle* client = nullptr);
+
+        /// \return The amount of acquire() calls served by an idle core.
+        inline quint64 hits() const { return m_hits; }
+        /// \return The amount of acquire() calls that had to create a core.
+        inline quint64 misses() const { return m_misses; }
+
+    private:
+        /// Stops playback of \p core and restores the properties players change.
+        static bool reset(mpv_handle* core);
+
+        /// Runs on m_reaper, recycles or destroys \p core.
+        void reap(mpv_handle* core, mpv_handle* client);
+
+        Factory m_factory;
+        const int m_size;
+
+        /// Guards m_idle and m_warming
+        QMutex m_lock;
+        QList<mpv_handle*> m_idle;
+        /// Cores being created by warmUp()
+        int m_warming;
+        QThreadPool m_workers;
+        /// Single thread destroying clients and resetting or destroying released cores
+        QThreadPool m_reaper;
+
+        std::atomic<quint64> m_hits;
+        std::atomic<quint64> m_misses;
+    };
+
+} // namespace Phonon::MPV
+
+#endif // PHONON_MPV_COREPOOL_H
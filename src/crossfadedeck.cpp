@@ -0,0 +1,159 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "crossfadedeck.h"
+
+#define MPV_ENABLE_DEPRECATED 0
+#include <mpv/client.h>
+
+#include "backend.h"
+#include "corepool.h"
+#include "utils/debug.h"
+#include "utils/events.h"
+
+// Events consumed by the deck, every other event is disabled on its core.
+static const std::initializer_list<mpv_event_id> HANDLED_EVENTS{
+    MPV_EVENT_COMMAND_REPLY,
+    MPV_EVENT_SET_PROPERTY_REPLY,
+    MPV_EVENT_END_FILE,
+    MPV_EVENT_PLAYBACK_RESTART,
+};
+
+using namespace Phonon::MPV;
+
+static QByteArray seconds(qint64 msecs) {
+    return QByteArray::number(msecs / 1000.0, 'f', 3);
+}
+
+CrossfadeDeck::CrossfadeDeck(QObject* parent)
+    : QObject(parent)
+    , m_core(nullptr)
+    , m_player(nullptr)
+    , m_drainPending(false)
+    , m_ready(false)
+    , m_running(false) {
+    m_events.notify = CrossfadeDeck::event_cb;
+    m_events.opaque = this;
+}
+
+CrossfadeDeck::~CrossfadeDeck() {
+    if(!m_player)
+        return;
+    Backend::self->dispatcher()->detach(m_player);
+    Backend::self->corePool()->release(m_core, m_player);
+}
+
+void CrossfadeDeck::event_cb(void* opaque) {
+    CrossfadeDeck* that = reinterpret_cast<CrossfadeDeck*>(opaque);
+    if(!that->m_drainPending.exchange(true))
+        QMetaObject::invokeMethod(that, &CrossfadeDeck::mpv_event_loop, Qt::QueuedConnection);
+}
+
+bool CrossfadeDeck::ensureCore() {
+    if(m_player)
+        return true;
+    if(!(m_core = Backend::self->corePool()->acquire())) {
+        error() << "Failed to get a crossfade core";
+        return false;
+    }
+    if(!(m_player = mpv_create_client(m_core, "crossfade"))) {
+        error() << "Failed to create crossfade client";
+        Backend::self->corePool()->release(m_core);
+        m_core = nullptr;
+        return false;
+    }
+    requestEvents(m_player, HANDLED_EVENTS);
+    m_requests.setHandle(m_player);
+    // Audio only, the tail is never shown. The pool restores both on release.
+    m_requests.setProperty("vid", QByteArray("no"));
+    m_requests.setProperty("sub-auto", QByteArray("no"));
+    Backend::self->dispatcher()->attach(m_player, &m_events);
+    return true;
+}
+
+bool CrossfadeDeck::prepare(const QByteArray& mrl, qint64 start, qint64 duration,
+                            const QByteArray& audioDevice, double volume, bool mute) {
+    DEBUG_BLOCK;
+    if(!ensureCore())
+        return false;
+    m_ready = false;
+    m_running = false;
+
+    if(!audioDevice.isEmpty())
+        m_requests.setProperty("audio-device", audioDevice);
+    m_requests.setProperty("volume", volume);
+    m_requests.setProperty("mute", mute);
+    // Timestamps of the filter are the ones of the source, the fade starts where the tail does.
+    m_requests.loadfile(RequestTracker::LoadOperation, mrl, "replace", {
+        {"pause", "yes"},
+        {"start", seconds(start)},
+        {"end", seconds(start + duration)},
+        {"af", "lavfi=[afade=t=out:st=" + seconds(start) + ":d=" + seconds(duration) + "]"},
+    });
+    debug() << "prepared crossfade tail of" << mrl << "at" << start << "ms";
+    return true;
+}
+
+void CrossfadeDeck::start() {
+    if(!m_ready)
+        return;
+    m_ready = false;
+    m_running = true;
+    m_requests.setProperty("pause", false);
+}
+
+void CrossfadeDeck::setPaused(bool paused) {
+    if(m_running)
+        m_requests.setProperty("pause", paused);
+}
+
+void CrossfadeDeck::cancel() {
+    if(!m_ready && !m_running)
+        return;
+    m_ready = false;
+    m_running = false;
+    m_requests.command(RequestTracker::StopOperation, {"stop"});
+}
+
+void CrossfadeDeck::mpv_event_loop() {
+    m_drainPending = false;
+    Event event;
+    while(m_events.events.pop(event)) {
+        switch(event.id) {
+            case MPV_EVENT_PLAYBACK_RESTART:
+                // The tail is opened and seeked, starting it only needs the unpause.
+                if(!m_running)
+                    m_ready = true;
+                break;
+            case MPV_EVENT_END_FILE:
+                m_ready = false;
+                m_running = false;
+                break;
+            case MPV_EVENT_COMMAND_REPLY:
+            case MPV_EVENT_SET_PROPERTY_REPLY: {
+                RequestTracker::Request request;
+                if(m_requests.finish(event.userdata, &request) && event.error < 0)
+                    warning() << "Crossfade core failed to run" << request.name << ":" << mpv_error_string(event.error);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    if(m_events.stalled)
+        Backend::self->dispatcher()->resume();
+}
@@ -0,0 +1,93 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_MPV_CROSSFADEDECK_H
+#define PHONON_MPV_CROSSFADEDECK_H
+
+#include <QByteArray>
+#include <QObject>
+
+#include <atomic>
+
+#include "eventdispatcher.h"
+#include "requesttracker.h"
+
+struct mpv_handle;
+
+namespace Phonon::MPV {
+
+    /** \brief Secondary audio-only core playing the tail of a source during a crossfade
+    *
+    * The MediaObject keeps playing on its own player and switches to the next source when
+    * the crossfade starts, the deck continues the previous source from there. The tail is
+    * opened paused ahead of time and faded out by an afade filter, so the gain ramp is
+    * sample accurate and independent of the GUI thread.
+    * The core is taken from the backend's CorePool on first use and reused for later transitions.
+    */
+    class CrossfadeDeck : public QObject {
+        Q_OBJECT
+
+    public:
+        explicit CrossfadeDeck(QObject* parent = nullptr);
+        ~CrossfadeDeck();
+
+        /**
+        * Opens \p mrl paused at \p start ms, playback fades out over \p duration ms from there
+        * and ends with the fade. The output follows \p audioDevice, \p volume and \p mute of the
+        * player that is faded out.
+        * \return \c false if the core could not be created.
+        */
+        bool prepare(const QByteArray& mrl, qint64 start, qint64 duration,
+                     const QByteArray& audioDevice, double volume, bool mute);
+
+        /// \return Whether the prepared tail is opened and starts without delay.
+        inline bool isReady() const { return m_ready; }
+
+        /// \return Whether the tail is playing.
+        inline bool isRunning() const { return m_running; }
+
+        /// Starts playing the prepared tail.
+        void start();
+
+        /// Pauses or resumes a running tail together with its player.
+        void setPaused(bool paused);
+
+        /// Drops the prepared or running tail.
+        void cancel();
+
+    private:
+        static void event_cb(void* opaque);
+
+        /// Acquires m_core and a client of it on first use.
+        bool ensureCore();
+
+        /// Drains the events the EventDispatcher queued for m_core.
+        void mpv_event_loop();
+
+        mpv_handle* m_core;
+        mpv_handle* m_player;
+        RequestTracker m_requests;
+        EventQueue m_events;
+        std::atomic<bool> m_drainPending;
+
+        bool m_ready;
+        bool m_running;
+    };
+
+} // namespace Phonon::MPV
+
+#endif // PHONON_MPV_CROSSFADEDECK_H
@@ -0,0 +1,125 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "devicecatalogue.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+
+#include "utils/debug.h"
+
+// Identifies the cache file format, bump on changes.
+static const quint32 CACHE_MAGIC = 0x70686463; // "phdc"
+static const quint32 CACHE_VERSION = 1;
+
+using namespace Phonon::MPV;
+
+DeviceCatalogue::DeviceCatalogue()
+    : m_nextIndex(0) {
+}
+
+bool DeviceCatalogue::update(const QVector<Device>& devices) {
+    auto changed{false};
+    QMap<int, bool> seen;
+    for(const auto& device : devices) {
+        auto index{-1};
+        for(auto it{m_entries.cbegin()}; it != m_entries.cend(); ++it) {
+            if(it->device.access == device.access) {
+                index = it.key();
+                break;
+            }
+        }
+        if(index < 0) {
+            index = m_nextIndex++;
+            m_entries.insert(index, Entry{device, false});
+        }
+        auto& entry{m_entries[index]};
+        if(!entry.present || entry.device.name != device.name || entry.device.description != device.description) {
+            debug() << "audio device" << index << device.name << "present";
+            entry.device = device;
+            entry.present = true;
+            changed = true;
+        }
+        seen.insert(index, true);
+    }
+    for(auto it{m_entries.begin()}; it != m_entries.end(); ++it) {
+        if(it->present && !seen.contains(it.key())) {
+            debug() << "audio device" << it.key() << it->device.name << "gone";
+            it->present = false;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+QList<int> DeviceCatalogue::indexes() const {
+    QList<int> result;
+    for(auto it{m_entries.cbegin()}; it != m_entries.cend(); ++it) {
+        if(it->present)
+            result.append(it.key());
+    }
+    return result;
+}
+
+const DeviceCatalogue::Device* DeviceCatalogue::device(int index) const {
+    const auto it{m_entries.constFind(index)};
+    if(it == m_entries.constEnd() || !it->present)
+        return nullptr;
+    return &it->device;
+}
+
+bool DeviceCatalogue::load(const QString& path) {
+    QFile file{path};
+    if(path.isEmpty() || !file.open(QIODevice::ReadOnly))
+        return false;
+    QDataStream stream{&file};
+    quint32 magic{0}, version{0};
+    qint32 nextIndex{0}, count{0};
+    stream >> magic >> version >> nextIndex >> count;
+    if(magic != CACHE_MAGIC || version != CACHE_VERSION || count < 0)
+        return false;
+
+    QMap<int, Entry> entries;
+    for(auto i{0}; i < count; i++) {
+        qint32 index;
+        Entry entry;
+        stream >> index >> entry.device.name >> entry.device.description
+               >> entry.device.access.first >> entry.device.access.second >> entry.present;
+        entries.insert(index, entry);
+    }
+    if(stream.status() != QDataStream::Ok) {
+        warning() << "Ignoring damaged device cache" << path;
+        return false;
+    }
+    m_entries = entries;
+    m_nextIndex = nextIndex;
+    return true;
+}
+
+bool DeviceCatalogue::save(const QString& path) const {
+    QSaveFile file{path};
+    if(path.isEmpty() || !file.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream stream{&file};
+    stream << CACHE_MAGIC << CACHE_VERSION << qint32(m_nextIndex) << qint32(m_entries.size());
+    for(auto it{m_entries.cbegin()}; it != m_entries.cend(); ++it) {
+        stream << qint32(it.key()) << it->device.name << it->device.description
+               << it->device.access.first << it->device.access.second << it->present;
+    }
+    return file.commit();
+}
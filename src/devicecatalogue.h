@@ -0,0 +1,78 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_MPV_DEVICECATALOGUE_H
+#define PHONON_MPV_DEVICECATALOGUE_H
+
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+#include <phonon/objectdescription.h>
+
+namespace Phonon::MPV {
+
+    /** \brief Indexed list of audio output devices that keeps indexes stable
+    *
+    * Devices are identified by their DeviceAccess. A device keeps its index while it is
+    * unplugged, so it comes back with the same index and indexes handed out to the
+    * application never change their meaning. The catalogue can be stored in a cache file,
+    * so device queries are answered before the core is initialized.
+    */
+    class DeviceCatalogue {
+    public:
+        struct Device {
+            QString name;
+            QString description;
+            DeviceAccess access;
+        };
+
+        DeviceCatalogue();
+
+        /**
+        * Replaces the present devices by \p devices. Known devices keep their index, new ones
+        * get the next free index.
+        * \return \c true if the present devices changed.
+        */
+        bool update(const QVector<Device>& devices);
+
+        /// \return The indexes of the present devices.
+        QList<int> indexes() const;
+
+        /// \return The present device with \p index, \c nullptr if there is none.
+        const Device* device(int index) const;
+
+        inline bool isEmpty() const { return indexes().isEmpty(); }
+
+        /// Replaces the catalogue by the one stored in \p path. \return \c false if it is not readable.
+        bool load(const QString& path);
+        /// Stores the catalogue in \p path. \return \c false if it could not be written.
+        bool save(const QString& path) const;
+
+    private:
+        struct Entry {
+            Device device;
+            bool present;
+        };
+
+        QMap<int, Entry> m_entries;
+        int m_nextIndex;
+    };
+
+} // namespace Phonon::MPV
+
+#endif // PHONON_MPV_DEVICECATALOGUE_H
@@ -0,0 +1,220 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "eventdispatcher.h"
+
+#include <QMutexLocker>
+
+#define MPV_ENABLE_DEPRECATED 0
+#include <mpv/client.h>
+
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "utils/debug.h"
+
+using namespace Phonon::MPV;
+
+// Maximum amount of ready clients handled per epoll_wait()
+static const int MAX_READY = 32;
+
+static void decode(const mpv_event* event, Event& out) {
+    out.id = event->event_id;
+    out.error = event->error;
+    out.userdata = event->reply_userdata;
+    out.format = MPV_FORMAT_NONE;
+    out.value.i = 0;
+    out.logLevel = 0;
+    out.entry = 0;
+    out.text.clear();
+
+    switch(event->event_id) {
+        case MPV_EVENT_LOG_MESSAGE: {
+            const auto msg{static_cast<mpv_event_log_message*>(event->data)};
+            out.logLevel = msg->log_level;
+            out.text.append('[').append(msg->prefix).append(']').append(msg->text);
+        }
+        break;
+        case MPV_EVENT_PROPERTY_CHANGE: {
+            const auto property{static_cast<mpv_event_property*>(event->data)};
+            out.format = property->format;
+            switch(property->format) {
+                case MPV_FORMAT_DOUBLE:
+                    out.value.d = *static_cast<double*>(property->data);
+                    break;
+                case MPV_FORMAT_FLAG:
+                    out.value.i = *static_cast<int*>(property->data);
+                    break;
+                case MPV_FORMAT_INT64:
+                    out.value.i = *static_cast<int64_t*>(property->data);
+                    break;
+                case MPV_FORMAT_STRING:
+                    out.text = *static_cast<char**>(property->data);
+                    break;
+                default:
+                    break;
+            }
+        }
+        break;
+        case MPV_EVENT_START_FILE:
+            out.entry = static_cast<mpv_event_start_file*>(event->data)->playlist_entry_id;
+            break;
+        case MPV_EVENT_END_FILE: {
+            const auto endFile{static_cast<mpv_event_end_file*>(event->data)};
+            out.value.i = endFile->reason;
+            out.error = endFile->error;
+            out.entry = endFile->playlist_entry_id;
+        }
+        break;
+        default:
+            break;
+    }
+}
+
+EventDispatcher::EventDispatcher(QObject* parent)
+    : QThread(parent)
+    , m_epoll(epoll_create1(EPOLL_CLOEXEC))
+    , m_control(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+    , m_quit(false)
+    , m_nextId(1) {
+    if(m_epoll < 0 || m_control < 0) {
+        fatal() << "Failed to set up the event dispatcher:" << strerror(errno);
+        return;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = 0; // Reserved for the control fd
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_control, &ev);
+    setObjectName(QStringLiteral("phonon-mpv events"));
+}
+
+EventDispatcher::~EventDispatcher() {
+    m_quit = true;
+    wake();
+    wait();
+    if(m_control >= 0)
+        close(m_control);
+    if(m_epoll >= 0)
+        close(m_epoll);
+}
+
+bool EventDispatcher::attach(mpv_handle* handle, EventQueue* queue) {
+    const auto fd{mpv_get_wakeup_pipe(handle)};
+    if(fd < 0) {
+        error() << "Failed to get the wakeup pipe of" << handle;
+        return false;
+    }
+
+    QMutexLocker lock(&m_lock);
+    const auto id{m_nextId++};
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = id;
+    if(epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev)) {
+        error() << "Failed to watch the wakeup pipe:" << strerror(errno);
+        return false;
+    }
+    m_clients.insert(id, Client{handle, queue, fd});
+    lock.unlock();
+
+    // Events that were queued before the pipe existed did not write to it.
+    queue->stalled = true;
+    resume();
+    return true;
+}
+
+void EventDispatcher::detach(mpv_handle* handle) {
+    QMutexLocker lock(&m_lock);
+    for(auto it{m_clients.begin()}; it != m_clients.end(); ++it) {
+        if(it->handle == handle) {
+            epoll_ctl(m_epoll, EPOLL_CTL_DEL, it->fd, nullptr);
+            m_clients.erase(it);
+            return;
+        }
+    }
+}
+
+void EventDispatcher::resume() {
+    wake();
+}
+
+void EventDispatcher::wake() {
+    const uint64_t one{1};
+    if(write(m_control, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        warning() << "Failed to wake the event dispatcher:" << strerror(errno);
+}
+
+void EventDispatcher::run() {
+    epoll_event ready[MAX_READY];
+    while(!m_quit) {
+        const auto count{epoll_wait(m_epoll, ready, MAX_READY, -1)};
+        if(count < 0) {
+            if(errno == EINTR)
+                continue;
+            fatal() << "Event dispatcher failed:" << strerror(errno);
+            return;
+        }
+
+        QMutexLocker lock(&m_lock);
+        for(auto i{0}; i < count; i++) {
+            const auto id{ready[i].data.u64};
+            if(!id) {
+                uint64_t value;
+                while(read(m_control, &value, sizeof(value)) > 0);
+                for(auto& client : m_clients) {
+                    if(client.queue->stalled.exchange(false))
+                        drain(client);
+                }
+                continue;
+            }
+            // The client might have been detached after epoll_wait() returned.
+            auto it{m_clients.find(id)};
+            if(it == m_clients.end())
+                continue;
+            char buffer[64];
+            while(read(it->fd, buffer, sizeof(buffer)) > 0);
+            drain(*it);
+        }
+    }
+}
+
+void EventDispatcher::drain(Client& client) {
+    auto batch{0};
+    Event record;
+    while(true) {
+        if(client.queue->events.isFull()) {
+            // Leave the rest in libmpv's queue until the consumer calls resume().
+            client.queue->stalled = true;
+            // The consumer might have emptied the queue and checked stalled before it was
+            // published, it would not call resume() then. Only leave if that is ruled out.
+            if(client.queue->events.isFull() || !client.queue->stalled.exchange(false))
+                break;
+            continue;
+        }
+        const auto event{mpv_wait_event(client.handle, 0)};
+        if(event->event_id == MPV_EVENT_NONE)
+            break;
+        decode(event, record);
+        client.queue->events.push(std::move(record));
+        batch++;
+    }
+    if(batch && client.queue->notify)
+        client.queue->notify(client.queue->opaque);
+}
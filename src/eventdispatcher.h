@@ -0,0 +1,127 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_MPV_EVENTDISPATCHER_H
+#define PHONON_MPV_EVENTDISPATCHER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QThread>
+
+#include <atomic>
+#include <cstdint>
+
+#include "utils/spscqueue.h"
+
+struct mpv_handle;
+
+namespace Phonon::MPV {
+
+    /** \brief Compact copy of an mpv_event
+    *
+    * Decoded on the dispatcher thread so the consumer never touches libmpv memory.
+    * Property payloads are stored by format, MPV_FORMAT_NODE properties only carry
+    * the notification and have to be fetched by the handler.
+    */
+    struct Event {
+        union Value {
+            double d;
+            int64_t i;
+        };
+
+        int id{0};
+        int error{0};
+        uint64_t userdata{0};
+        /// mpv_format of a property payload, 0 (MPV_FORMAT_NONE) if the property is unavailable
+        int format{0};
+        /// MPV_FORMAT_DOUBLE in d, MPV_FORMAT_FLAG and MPV_FORMAT_INT64 in i, end file reason in i
+        Value value{};
+        int logLevel{0};
+        /// playlist_entry_id of START_FILE and END_FILE
+        int64_t entry{0};
+        /// MPV_FORMAT_STRING payload or "[prefix]text" of log messages
+        QByteArray text;
+    };
+
+    /** \brief Receiving end of a client registered with the EventDispatcher
+    *
+    * The dispatcher thread is the only producer, the owner of the queue the only consumer.
+    * After a batch was queued notify(opaque) is called on the dispatcher thread.
+    */
+    struct EventQueue {
+        SpscQueue<Event, 1024> events;
+
+        /// Set by the dispatcher when it stopped draining the client because events was full
+        std::atomic<bool> stalled{false};
+
+        void (*notify)(void*){nullptr};
+        void* opaque{nullptr};
+    };
+
+    /** \brief Backend wide I/O thread waiting on the wakeup pipes of all mpv clients
+    *
+    * Every client is drained on this thread, its events are decoded into Event records
+    * and handed to the EventQueue of the client in batches. This keeps the cost on the GUI
+    * thread independent of the amount of players.
+    */
+    class EventDispatcher : public QThread {
+        Q_OBJECT
+
+    public:
+        explicit EventDispatcher(QObject* parent = nullptr);
+        ~EventDispatcher();
+
+        /**
+        * Starts dispatching the events of \p handle into \p queue. The handle must not be
+        * drained with mpv_wait_event() anywhere else afterwards.
+        */
+        bool attach(mpv_handle* handle, EventQueue* queue);
+
+        /// Stops dispatching. When this returns the dispatcher does not touch \p handle anymore.
+        void detach(mpv_handle* handle);
+
+        /// Continues draining stalled clients, to be called once a consumer made room.
+        void resume();
+
+    protected:
+        void run() Q_DECL_OVERRIDE;
+
+    private:
+        struct Client {
+            mpv_handle* handle;
+            EventQueue* queue;
+            int fd;
+        };
+
+        void drain(Client& client);
+        void wake();
+
+        int m_epoll;
+        /// eventfd used to interrupt epoll_wait() for resume and shutdown
+        int m_control;
+        std::atomic<bool> m_quit;
+        quint64 m_nextId;
+
+        /// Guards m_clients, held while a client is drained
+        QMutex m_lock;
+        QHash<quint64, Client> m_clients;
+    };
+
+} // namespace Phonon::MPV
+
+#endif // PHONON_MPV_EVENTDISPATCHER_H
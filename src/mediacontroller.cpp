@@ -33,7 +33,8 @@
 using namespace Phonon::MPV;
 
 MediaController::MediaController()
-    : m_subtitleAutodetect(true)
+    : m_subtitleFileRequest(0)
+    , m_subtitleAutodetect(true)
     , m_subtitleEncoding("UTF-8")
     , m_subtitleFontChanged(false)
     , m_player(nullptr)
@@ -231,16 +232,46 @@ void MediaController::resetMembers() {
     m_availableTitles = 0;
 
     m_attemptingAutoplay = false;
+
+    m_pendingAudioChannel = Phonon::AudioChannelDescription();
+    m_pendingSubtitle = Phonon::SubtitleDescription();
+    m_pendingSubtitleFile = Phonon::SubtitleDescription();
+    m_subtitleFileRequest = 0;
+}
+
+void MediaController::requestFinished(quint64 id, const RequestTracker::Request& request, bool succeeded) {
+    if(request.operation == RequestTracker::CommandOperation) {
+        if(id != m_subtitleFileRequest)
+            return;
+        m_subtitleFileRequest = 0;
+        if(succeeded) {
+            m_currentSubtitle = m_pendingSubtitleFile;
+            GlobalSubtitles::instance()->add(this, m_currentSubtitle);
+            emit availableSubtitlesChanged();
+        }
+        m_pendingSubtitleFile = Phonon::SubtitleDescription();
+        return;
+    }
+    // Coalesced writes of a track are still being sent, the last one decides.
+    if(request.operation != RequestTracker::PropertyOperation || m_requests.isWriting(request.name))
+        return;
+    if(request.name == "aid") {
+        if(succeeded)
+            m_currentAudioChannel = m_pendingAudioChannel;
+        m_pendingAudioChannel = Phonon::AudioChannelDescription();
+    } else if(request.name == "sid") {
+        if(succeeded)
+            m_currentSubtitle = m_pendingSubtitle;
+        m_pendingSubtitle = Phonon::SubtitleDescription();
+    }
 }
 
 // ----------------------------- Audio Channel ------------------------------ //
 void MediaController::setCurrentAudioChannel(const Phonon::AudioChannelDescription& audioChannel) {
-    int64_t localIndex = GlobalAudioChannels::instance()->localIdFor(this, audioChannel.index());
-    auto err{0};
-    if((err = mpv_set_property(m_player, "aid", MPV_FORMAT_INT64, &localIndex)))
-        error() << "Failed to set Audio Track:" << mpv_error_string(err);
-    else
-        m_currentAudioChannel = audioChannel;
+    const qint64 localIndex = GlobalAudioChannels::instance()->localIdFor(this, audioChannel.index());
+    // The selection only changes once mpv accepted the write, see requestFinished().
+    if(m_requests.setProperty("aid", localIndex))
+        m_pendingAudioChannel = audioChannel;
 }
 
 QList<Phonon::AudioChannelDescription> MediaController::availableAudioChannels() const {
@@ -294,35 +325,23 @@ void MediaController::setCurrentSubtitle(const Phonon::SubtitleDescription &subt
 
     debug() << subtitle;
 
-    auto err{0};
     if(type == "file") {
         QString filename{subtitle.property("name").toString()};
         if(!filename.isEmpty()) {
-            const char* cmd[] = {"sub-add", filename.toUtf8().constData(), nullptr};
-            if((err = mpv_command(m_player, cmd)))
-                error() << "Failed to set Subtitle:" << mpv_error_string(err);
-            else
-                m_currentSubtitle = subtitle;
-
-            GlobalSubtitles::instance()->add(this, m_currentSubtitle);
-            emit availableSubtitlesChanged();
+            if((m_subtitleFileRequest = m_requests.command(RequestTracker::CommandOperation, {"sub-add", filename.toUtf8()})))
+                m_pendingSubtitleFile = subtitle;
         }
     } else {
-        int64_t localIndex{GlobalSubtitles::instance()->localIdFor(this, subtitle.index())};
+        const qint64 localIndex{GlobalSubtitles::instance()->localIdFor(this, subtitle.index())};
         debug() << "localid" << localIndex;
-        if((err = mpv_set_property(m_player, "sid", MPV_FORMAT_INT64, &localIndex)))
-            error() << "Failed to set Subtitle:" << mpv_error_string(err);
-        else
-            m_currentSubtitle = subtitle;
+        if(m_requests.setProperty("sid", localIndex))
+            m_pendingSubtitle = subtitle;
     }
 }
 
 void MediaController::setCurrentSubtitleFile(const QUrl &url) {
     const QString file{url.toLocalFile()};
-    auto err{0};
-    const char* cmd[] = {"sub-add", file.toUtf8().constData(), nullptr};
-    if((err = mpv_command(m_player, cmd)))
-        error() << "Failed to set Subtitle File:" << mpv_error_string(err);
+    m_requests.command(RequestTracker::CommandOperation, {"sub-add", file.toUtf8()});
     // Unfortunately the addition of SPUs does not trigger an event in the
     // MPV mediaplayer, yet the actual addition to the descriptor is async.
     // So for the time being our best shot at getting an up-to-date list of SPUs
@@ -414,18 +433,15 @@ void MediaController::setCurrentTitle(int title) {
     DEBUG_BLOCK;
     m_currentTitle = title;
 
-    auto err{0};
-    int64_t id{title};
+    const qint64 id{title};
     switch(source().discType()) {
         case Cd:
-            if((err = mpv_set_property(m_player, "playlist-pos", MPV_FORMAT_INT64, &id)))
-                error() << "Failed to set track:" << mpv_error_string(err);
+            m_requests.setProperty("playlist-pos", id);
             return;
         case Dvd:
         case Vcd:
         case BluRay:
-            if((err = mpv_set_property(m_player, "disc-title", MPV_FORMAT_INT64, &id)))
-                error() << "Failed to set title:" << mpv_error_string(err);
+            m_requests.setProperty("disc-title", id);
             return;
         case NoDisc:
             warning() << "Current media source is not a CD, DVD or VCD!";
@@ -464,10 +480,7 @@ void MediaController::refreshTitles() {
 // -------------------------------- Chapter --------------------------------- //
 void MediaController::setCurrentChapter(int chapter) {
     m_currentChapter = chapter;
-    auto err{0};
-    int64_t id{chapter};
-    if((err = mpv_set_property(m_player, "chapter", MPV_FORMAT_INT64, &id)))
-        error() << "Failed to set chapter:" << mpv_error_string(err);
+    m_requests.setProperty("chapter", qint64{chapter});
 }
 
 int MediaController::availableChapters() const {
@@ -492,10 +505,7 @@ void MediaController::refreshChapters() {
 // --------------------------------- Angle ---------------------------------- //
 void MediaController::setCurrentAngle(int angle) {
     m_currentAngle = angle;
-    auto err{0};
-    int64_t id{angle};
-    if((err = mpv_set_property(m_player, "angle", MPV_FORMAT_INT64, &id)))
-        error() << "Failed to set angle:" << mpv_error_string(err);
+    m_requests.setProperty("angle", qint64{angle});
 }
 
 int MediaController::availableAngles() const {
@@ -27,6 +27,8 @@
 
 #include <QtGui/QFont>
 
+#include "requesttracker.h"
+
 class QTimer;
 struct mpv_handle;
 
@@ -131,9 +133,21 @@ protected:
      */
     void resetMembers();
 
+    /**
+    * Applies a track selection once the write of \p request completed, a failed
+    * write leaves the current selection untouched.
+    */
+    void requestFinished(quint64 id, const RequestTracker::Request& request, bool succeeded);
+
     Phonon::AudioChannelDescription m_currentAudioChannel;
     Phonon::SubtitleDescription m_currentSubtitle;
 
+    /// Selections waiting for their aid, sid or sub-add request
+    Phonon::AudioChannelDescription m_pendingAudioChannel;
+    Phonon::SubtitleDescription m_pendingSubtitle;
+    Phonon::SubtitleDescription m_pendingSubtitleFile;
+    quint64 m_subtitleFileRequest;
+
     int m_currentChapter;
     int m_availableChapters;
 
@@ -152,6 +166,7 @@ protected:
 
     // MediaPlayer
     mpv_handle* m_player;
+    RequestTracker m_requests;
 
     QTimer *m_refreshTimer;
 
@@ -23,6 +23,7 @@
 #include "mediaobject.h"
 
 #include <QDir>
+#include <QElapsedTimer>
 #include <QStringBuilder>
 #include <QUrl>
 
@@ -30,57 +31,131 @@
 #include <mpv/client.h>
 
 #include "utils/debug.h"
+#include "utils/events.h"
 #include "backend.h"
+#include "corepool.h"
+#include "crossfadedeck.h"
+#include "eventdispatcher.h"
 #include "sinknode.h"
-
-//Time in milliseconds before sending aboutToFinish() signal
-//2 seconds
-static const int ABOUT_TO_FINISH_TIME = 2000;
+#include "thumbnailservice.h"
+
+// Maximum amount of events and time a single drain may spend on the GUI thread
+// before yielding back to the Qt event loop.
+static const int EVENT_BUDGET = 64;
+static const qint64 EVENT_TIME_BUDGET_NS = 4 * 1000 * 1000;
+
+// Events consumed by mpv_event_loop(), every other event is disabled on the client.
+static const std::initializer_list<mpv_event_id> HANDLED_EVENTS{
+    MPV_EVENT_SHUTDOWN,
+    MPV_EVENT_LOG_MESSAGE,
+    MPV_EVENT_COMMAND_REPLY,
+    MPV_EVENT_SET_PROPERTY_REPLY,
+    MPV_EVENT_START_FILE,
+    MPV_EVENT_END_FILE,
+    MPV_EVENT_FILE_LOADED,
+    MPV_EVENT_PLAYBACK_RESTART,
+    MPV_EVENT_PROPERTY_CHANGE,
+};
 
 using namespace Phonon::MPV;
 
+constexpr PropertyBinding<MediaObject> MediaObject::s_properties[PropertyCount]{
+    bindProperty<&MediaObject::onTimePos>("time-pos"),
+    bindProperty<&MediaObject::onSeekable>("seekable"),
+    bindProperty<&MediaObject::onDuration>("duration"),
+    bindProperty<&MediaObject::onPausedForCache>("paused-for-cache"),
+    bindProperty<&MediaObject::onCacheBufferingState>("cache-buffering-state"),
+    bindProperty<&MediaObject::onPause>("pause"),
+    bindProperty<&MediaObject::onCurrentVo>("current-vo"),
+    bindProperty<&MediaObject::onMetadata>("metadata"),
+    bindProperty<&MediaObject::onMute>("mute"),
+    bindProperty<&MediaObject::onVolume>("volume"),
+    bindProperty<&MediaObject::onSpeed>("speed"),
+    bindProperty<&MediaObject::onVideoFormat>("video-format", true),
+    bindProperty<&MediaObject::onCurrentDemuxer>("current-demuxer", true),
+    bindProperty<&MediaObject::onFileFormat>("file-format", true),
+};
+
 MediaObject::MediaObject(QObject* parent)
     : QObject(parent)
+    , m_properties(s_properties)
+    , m_core(nullptr)
     , m_nextSource(MediaSource(QUrl()))
     , m_state(Phonon::StoppedState)
     , m_tickInterval(0)
-    , m_transitionTime(0) {
-
-    if(!(m_player = mpv_create_client(Backend::self->handle(), nullptr))) {
+    , m_transitionTime(0)
+    , m_deck(nullptr)
+    , m_crossfadePending(false)
+    , m_rearmOnTimePos(false)
+    , m_handoffLatency(-1)
+    , m_thumbnails(nullptr)
+    , m_preroll(qEnvironmentVariableIntValue("PHONON_MPV_PREROLL") > 0)
+    , m_prerolling(false)
+    , m_pauseOnReady(false)
+    , m_loadPending(false)
+    , m_probeHinted(false)
+    , m_loadStart(0)
+    , m_timeToReady(-1)
+    , m_timeToFirstSample(-1)
+    , m_drainPending(false) {
+
+    // Every player has a core of its own, so players do not share playlist and state.
+    if(!(m_core = Backend::self->corePool()->acquire())) {
+        fatal() << "Failed to get a MPV core";
+        return;
+    }
+    if(!(m_player = mpv_create_client(m_core, nullptr))) {
         fatal() << "Failed to create MPV Client";
         return;
     }
 
     if(qgetenv("PHONON_BACKEND_DEBUG").toInt() >= 3) // 3 is maximum
         mpv_request_log_messages(m_player, "v");
-    mpv_observe_property(m_player, 0, "time-pos", MPV_FORMAT_DOUBLE);
-    mpv_observe_property(m_player, 1, "seekable", MPV_FORMAT_FLAG);
-    mpv_observe_property(m_player, 2, "duration", MPV_FORMAT_DOUBLE);
-    mpv_observe_property(m_player, 3, "paused-for-cache", MPV_FORMAT_FLAG);
-    mpv_observe_property(m_player, 5, "pause", MPV_FORMAT_FLAG);
-    mpv_observe_property(m_player, 7, "current-vo", MPV_FORMAT_STRING);
-    mpv_observe_property(m_player, 8, "metadata", MPV_FORMAT_NODE);
-    mpv_observe_property(m_player, 9, "mute", MPV_FORMAT_FLAG);
-    mpv_observe_property(m_player, 10, "volume", MPV_FORMAT_INT64);
-    mpv_set_wakeup_callback(m_player, MediaObject::event_cb, this);
+    // Sinks attach to the properties only they consume (cache-buffering-state, mute, volume).
+    for(const auto property : {TimePosProperty, SeekableProperty, DurationProperty, PausedForCacheProperty,
+                               PauseProperty, CurrentVoProperty, MetadataProperty, SpeedProperty,
+                               VideoFormatProperty, CurrentDemuxerProperty, FileFormatProperty})
+        attachProperty(property);
+    requestEvents(m_player, HANDLED_EVENTS);
+    m_requests.setHandle(m_player);
+    m_events.notify = MediaObject::event_cb;
+    m_events.opaque = this;
+    Backend::self->dispatcher()->attach(m_player, &m_events);
 
     // Internal Signals.
     connect(this, SIGNAL(moveToNext()), SLOT(moveToNextSource()));
     connect(m_refreshTimer, SIGNAL(timeout()), this, SLOT(refreshDescriptors()));
+    m_tickTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_tickTimer, SIGNAL(timeout()), SLOT(emitTick()));
+    m_aboutToFinishTimer.setSingleShot(true);
+    connect(&m_aboutToFinishTimer, &QTimer::timeout, this, &MediaObject::emitAboutToFinish);
+    m_prefinishTimer.setSingleShot(true);
+    connect(&m_prefinishTimer, SIGNAL(timeout()), SLOT(emitPrefinishMark()));
+    m_crossfadeTimer.setSingleShot(true);
+    connect(&m_crossfadeTimer, SIGNAL(timeout()), SLOT(startCrossfade()));
+    m_gapTimer.setSingleShot(true);
+    connect(&m_gapTimer, SIGNAL(timeout()), SLOT(moveToNextSource()));
 
     resetMembers();
 }
 
 MediaObject::~MediaObject() {
-    mpv_destroy(m_player);
+    // Sinks must not keep using the core once it is recycled.
+    for(auto sink : QList<SinkNode*>(m_sinks))
+        sink->disconnectFromMediaObject(this);
+    delete m_deck;
+    m_deck = nullptr;
+    // Shutting down playback blocks, the pool destroys the client and recycles the core
+    // on its reaper thread.
+    Backend::self->dispatcher()->detach(m_player);
+    Backend::self->corePool()->release(m_core, m_player);
 }
 
 void MediaObject::event_cb(void *opaque) {
     MediaObject* that = reinterpret_cast<MediaObject*>(opaque);
-    QMetaObject::invokeMethod(
-                    that,
-                    "mpv_event_loop",
-                    Qt::QueuedConnection);
+    // Called from the dispatcher thread, only post a drain if none is queued yet.
+    if(!that->m_drainPending.exchange(true))
+        QMetaObject::invokeMethod(that, &MediaObject::mpv_event_loop, Qt::QueuedConnection);
 }
 
 
@@ -90,9 +165,25 @@ void MediaObject::resetMembers() {
     m_totalTime = -1;
     m_hasVideo = false;
     m_seekpoint = 0;
+    m_seeking = false;
+    m_scrubbing = false;
+    m_seekTarget = 0;
+    m_pendingSeek = -1;
+    m_nextQueued = false;
+    m_playlistEntry = -1;
     m_prefinishEmitted = false;
     m_aboutToFinishEmitted = false;
-    m_lastTick = 0;
+    m_rearmOnTimePos = false;
+    m_aboutToFinishTimer.stop();
+    m_prefinishTimer.stop();
+    m_openTimer.invalidate();
+    m_prerolling = false;
+    m_pauseOnReady = false;
+    m_probeHinted = false;
+    m_firstSampleTimer.invalidate();
+    m_prefetcher.cancel();
+    cancelTransition();
+    m_clock.reset();
     m_buffering = false;
     m_stateAfterBuffering = ErrorState;
     resetMediaController();
@@ -100,86 +191,170 @@ void MediaObject::resetMembers() {
 
 void MediaObject::play() {
     DEBUG_BLOCK;
-    if(m_state == PausedState) {
-        auto err{0};
-        auto play{0};
-        if((err = mpv_set_property(m_player, "pause", MPV_FORMAT_FLAG, &play)))
-            error() << "Failed to play file" << mpv_error_string(err);
+    if(m_prerolling || m_pauseOnReady) {
+        // Ready or still opening, either way mpv only has to unpause.
+        m_prerolling = false;
+        m_pauseOnReady = false;
+        m_firstSampleTimer.start();
+        m_requests.setProperty("pause", false);
+    } else if(m_state == PausedState) {
+        m_requests.setProperty("pause", false);
     }
 }
 
 void MediaObject::pause() {
     DEBUG_BLOCK;
-    if(m_state == BufferingState || m_state == PlayingState) {
-        auto err{0};
-        auto pause{1};
-        if((err = mpv_set_property(m_player, "pause", MPV_FORMAT_FLAG, &pause)))
-            error() << "Failed to pause file" << mpv_error_string(err);
+    if(m_prerolling && m_state == StoppedState) {
+        // The pre-rolled source already is paused.
+        m_prerolling = false;
+        updateState(PausedState);
+    } else if(m_prerolling && m_state == LoadingState) {
+        // Still opening paused, it becomes PausedState instead of StoppedState once ready.
+        m_prerolling = false;
+        m_pauseOnReady = true;
+    } else if(m_state == BufferingState || m_state == PlayingState) {
+        m_requests.setProperty("pause", true);
     }
 }
 
 void MediaObject::stop() {
     DEBUG_BLOCK;
     m_nextSource = MediaSource(QUrl());
-    auto err{0};
-    const char* cmd[] = {"stop", nullptr};
-    if((err = mpv_command(m_player, cmd)))
-        error() << "Failed to stop media:" << mpv_error_string(err);
+    m_nextQueued = false;
+    m_prerolling = false;
+    m_pauseOnReady = false;
+    m_loadPending = false;
+    // A seek in flight does not land anymore, later seeks must not wait for it.
+    m_seeking = false;
+    m_scrubbing = false;
+    m_pendingSeek = -1;
+    m_prefetcher.cancel();
+    cancelTransition();
+    m_requests.command(RequestTracker::StopOperation, {"stop"});
     updateState(StoppedState);
 }
 
 void MediaObject::seek(qint64 milliseconds) {
     DEBUG_BLOCK;
 
-    if(m_state != PlayingState && m_state != PausedState && m_state != BufferingState) {
+    // A pre-rolled source is loaded, seeking it paused keeps play() instant.
+    if(m_state != PlayingState && m_state != PausedState && m_state != BufferingState
+       && !(m_prerolling && m_state == StoppedState)) {
         m_seekpoint = milliseconds;
         return;
     }
 
     debug() << "seeking" << milliseconds << "msec";
 
-    auto err{0};
-    double nowTime{milliseconds / 1000.0f};
-    if((err = mpv_set_property(m_player, "time-pos", MPV_FORMAT_DOUBLE, &nowTime)))
-        error() << "Failed to set time:" << mpv_error_string(err);
+    // Report the target right away, sliders should not jump back while the seek runs.
+    m_clock.update(milliseconds / 1000.0);
+
+    if(m_seeking) {
+        // Scrubbing: only the latest target survives until the running seek landed.
+        m_pendingSeek = milliseconds;
+        return;
+    }
+    startSeek(milliseconds, false);
+}
 
+void MediaObject::startSeek(qint64 milliseconds, bool fast) {
+    m_seeking = true;
+    m_scrubbing = fast;
+    m_seekTarget = milliseconds;
+    const auto flags{fast ? QByteArray("absolute+keyframes") : QByteArray("absolute+exact")};
+    if(!m_requests.command(RequestTracker::SeekOperation, {"seek", QByteArray::number(milliseconds / 1000.0, 'f', 3), flags}))
+        m_seeking = false;
+}
+
+void MediaObject::seekLanded() {
+    if(m_pendingSeek >= 0) {
+        // More targets arrived while seeking, keep up with keyframe seeks.
+        const auto target{m_pendingSeek};
+        m_pendingSeek = -1;
+        startSeek(target, true);
+        return;
+    }
+    if(m_scrubbing) {
+        // Scrubbing ended, refine to the exact position of the last target.
+        startSeek(m_seekTarget, false);
+        return;
+    }
+    m_seeking = false;
+    rearmFinishSignals();
+    emit seekCompleted(currentTime());
+}
+
+void MediaObject::rearmFinishSignals() {
     const qint64 time = currentTime();
     const qint64 total = totalTime();
 
-    // Reset last tick marker so we emit time even after seeking
-    if(time < m_lastTick)
-        m_lastTick = time;
     if(time < total - m_prefinishMark)
         m_prefinishEmitted = false;
-    if(time < total - ABOUT_TO_FINISH_TIME)
+    if(time < total - aboutToFinishLead())
         m_aboutToFinishEmitted = false;
+    scheduleFinishSignals();
 }
 
 void MediaObject::timeChanged(qint64 time) {
-    const qint64 totalTime = m_totalTime;
+    // While playing ticks come from m_tickTimer, position changes while paused are seeks.
+    if(m_state == PausedState && m_tickInterval > 0)
+        emit tick(time);
+}
 
-    if(m_state == PlayingState || m_state == BufferingState || m_state == PausedState)
-        emitTick(time);
+void MediaObject::emitTick() {
+    emit tick(m_clock.time());
+}
 
-    if(m_state == PlayingState || m_state == BufferingState) { // Buffering is concurrent
-        if (time >= totalTime - m_prefinishMark) {
-            if (!m_prefinishEmitted) {
-                m_prefinishEmitted = true;
-                emit prefinishMarkReached(totalTime - time);
-            }
-        }
-        // Note that when the totalTime is <= 0 we cannot calculate any sane delta.
-        if (totalTime > 0 && time >= totalTime - ABOUT_TO_FINISH_TIME)
-            emitAboutToFinish();
-    }
+void MediaObject::emitPrefinishMark() {
+    if(m_prefinishEmitted)
+        return;
+    m_prefinishEmitted = true;
+    emit prefinishMarkReached(qMax<qint64>(0, m_totalTime - m_clock.time()));
 }
 
-void MediaObject::emitTick(qint64 time) {
-    if (m_tickInterval == 0) // Make sure we do not ever emit ticks when deactivated.\]
+void MediaObject::scheduleFinishSignals() {
+    m_aboutToFinishTimer.stop();
+    m_prefinishTimer.stop();
+    m_crossfadeTimer.stop();
+    // The clock only advances while playing, changeState() schedules again on resume.
+    // Note that when the total time is <= 0 we cannot calculate any sane delta.
+    if(m_state != PlayingState || m_totalTime <= 0)
         return;
-    if (time + m_tickInterval >= m_lastTick) {
-        m_lastTick = time;
-        emit tick(time);
+
+    const auto speed{m_observed.speed > 0 ? m_observed.speed : 1.0};
+    const auto remaining{m_totalTime - m_clock.time()};
+    if(!m_aboutToFinishEmitted) {
+        // The lead covers opening the next source, that takes wall clock time.
+        // A crossfade additionally needs the next source before the overlap starts.
+        const auto lead{aboutToFinishLead() + qMax<qint64>(0, m_transitionTime)};
+        const auto delay{static_cast<qint64>(remaining / speed) - lead};
+        m_aboutToFinishTimer.start(static_cast<int>(qMax<qint64>(0, delay)));
+    }
+    if(m_crossfadePending) {
+        const auto delay{static_cast<qint64>((remaining - m_transitionTime) / speed)};
+        m_crossfadeTimer.start(static_cast<int>(qMax<qint64>(0, delay)));
+    }
+    if(!m_prefinishEmitted) {
+        const auto delay{static_cast<qint64>((remaining - m_prefinishMark) / speed)};
+        m_prefinishTimer.start(static_cast<int>(qMax<qint64>(0, delay)));
+    }
+}
+
+qint64 MediaObject::aboutToFinishLead() const {
+    if(!m_nextMrl.isEmpty() && m_nextSource.type() != MediaSource::Invalid && m_nextSource.type() != MediaSource::Empty)
+        return Backend::self->aboutToFinishLead(m_nextMrl);
+    // The next source is usually set in response to aboutToFinish(), its scheme is unknown.
+    // Sources of the current scheme may open faster, that must not shorten the default.
+    return qMax(Backend::self->aboutToFinishLead(m_mrl), Backend::self->aboutToFinishLead(QByteArray()));
+}
+
+void MediaObject::updateTickTimer() {
+    // Make sure we do not ever emit ticks when deactivated.
+    if(m_tickInterval > 0 && m_state == PlayingState) {
+        if(!m_tickTimer.isActive() || m_tickTimer.interval() != m_tickInterval)
+            m_tickTimer.start(m_tickInterval);
+    } else {
+        m_tickTimer.stop();
     }
 }
 
@@ -191,14 +366,54 @@ void MediaObject::loadMedia(const QString &mrl) {
     debug() << "loading encoded:" << m_mrl;
     if(mrl.length())
         m_mrl = mrl.toUtf8();
+    if(m_thumbnails)
+        m_thumbnails->setSource(m_mrl);
     resetMembers();
-    auto err{0};
     if(m_state == PlayingState)
         updateState(StoppedState);
-    const char* cmd[]{"loadfile", m_mrl.constData(), nullptr};
     debug() << "Play File " << m_mrl;
-    if((err = mpv_command(m_player, cmd)))
-        error() << "Failed to load media:" << mpv_error_string(err);
+    m_openTimer.start();
+    // A source following one that played keeps playing, e.g. from moveToNextSource().
+    if(m_preroll && m_state != PlayingState && m_state != BufferingState)
+        m_prerolling = true;
+    else
+        m_firstSampleTimer.start();
+    // Seeks right after setSource(), e.g. resuming a podcast, still make it into the loadfile.
+    if(!m_loadPending) {
+        m_loadPending = true;
+        QMetaObject::invokeMethod(this, &MediaObject::issueLoad, Qt::QueuedConnection);
+    }
+}
+
+void MediaObject::issueLoad() {
+    if(!m_loadPending)
+        return;
+    m_loadPending = false;
+    // The replaced playlist entries end, the new one is identified by its START_FILE.
+    m_playlistEntry = -1;
+    // Requests run in order, a play() after this still unpauses after the load.
+    if(m_prerolling || m_pauseOnReady)
+        m_requests.setProperty("pause", true);
+    auto options{Backend::self->loadOptions(m_mrl)};
+    // Skip probing the container if it was opened before, see the END_FILE fallback.
+    const auto hints{Backend::self->probeCache().hints(m_mrl)};
+    m_probeHinted = !hints.isEmpty();
+    options.append(hints);
+    m_loadStart = m_seekpoint;
+    if(m_seekpoint > 0) {
+        // The demuxer opens at the target instead of decoding from 0 and seeking.
+        debug() << "opening at" << m_seekpoint << "msec";
+        options.append({"start", QByteArray::number(m_seekpoint / 1000.0, 'f', 3)});
+        m_seekpoint = 0;
+    }
+    m_requests.loadfile(RequestTracker::LoadOperation, m_mrl, "replace", options);
+}
+
+void MediaObject::recordProbe() {
+    // Both properties change while the source opens, record once the pair is complete.
+    if(m_observed.demuxer.isEmpty() || (m_observed.demuxer == "lavf" && m_observed.fileFormat.isEmpty()))
+        return;
+    Backend::self->probeCache().record(m_mrl, m_observed.demuxer, m_observed.fileFormat);
 }
 
 qint32 MediaObject::tickInterval() const {
@@ -211,6 +426,7 @@ qint32 MediaObject::tickInterval() const {
  */
 void MediaObject::setTickInterval(qint32 interval) {
     m_tickInterval = interval;
+    updateTickTimer();
 }
 
 qint64 MediaObject::currentTime() const {
@@ -219,14 +435,9 @@ qint64 MediaObject::currentTime() const {
     switch (m_state) {
         case PausedState:
         case BufferingState:
-        case PlayingState: {
-            auto err{0};
-            double duration{0.0f};
-            if((err = mpv_get_property(m_player, "time-pos", MPV_FORMAT_DOUBLE, &duration)))
-                warning() << "Failed to get time:" << mpv_error_string(err);
-            time = duration * 1000;
-        }
-        break;
+        case PlayingState:
+            time = m_clock.time();
+            break;
         case StoppedState:
         case LoadingState:
             time = 0;
@@ -240,7 +451,6 @@ qint64 MediaObject::currentTime() const {
 }
 
 Phonon::State MediaObject::state() const {
-    DEBUG_BLOCK;
     return m_state;
 }
 
@@ -258,6 +468,19 @@ void MediaObject::setSource(const MediaSource &source) {
     DEBUG_BLOCK;
 
     m_mediaSource = source;
+    if(source.type() == MediaSource::Disc && source.discType() == Phonon::NoDisc) {
+        error() << Q_FUNC_INFO << "the MediaSource::Disc doesn't specify which one (Phonon::NoDisc)";
+        return;
+    }
+    const auto mrl{mrlForSource(source)};
+    if(!mrl.isEmpty())
+        loadMedia(mrl);
+
+    debug() << "Sending currentSourceChanged";
+    emit currentSourceChanged(m_mediaSource);
+}
+
+QByteArray MediaObject::mrlForSource(const MediaSource& source) const {
     QByteArray url;
     switch(source.type()) {
         case MediaSource::Invalid:
@@ -278,24 +501,22 @@ void MediaObject::setSource(const MediaSource &source) {
                     url.append(QFile::encodeName(QDir::currentPath()) + '/');
             }
             url += source.url().toEncoded();
-            loadMedia(url);
             break;
         case MediaSource::Disc:
             switch (source.discType()) {
                 case Phonon::NoDisc:
-                    error() << Q_FUNC_INFO << "the MediaSource::Disc doesn't specify which one (Phonon::NoDisc)";
-                    return;
+                    break;
                 case Phonon::Cd:
-                    loadMedia(QStringLiteral("cdda://") % m_mediaSource.deviceName());
+                    url = QString(QStringLiteral("cdda://") % source.deviceName()).toUtf8();
                     break;
                 case Phonon::Dvd:
-                    loadMedia(QStringLiteral("dvd://") % m_mediaSource.deviceName());
+                    url = QString(QStringLiteral("dvd://") % source.deviceName()).toUtf8();
                     break;
                 case Phonon::Vcd:
-                    loadMedia(QStringLiteral("vcd://") % m_mediaSource.deviceName());
+                    url = QString(QStringLiteral("vcd://") % source.deviceName()).toUtf8();
                     break;
                 case Phonon::BluRay:
-                    loadMedia(QStringLiteral("bluray://") % m_mediaSource.deviceName());
+                    url = QString(QStringLiteral("bluray://") % source.deviceName()).toUtf8();
                     break;
             }
             break;
@@ -313,11 +534,11 @@ void MediaObject::setSource(const MediaSource &source) {
             deviceName = source.deviceAccessList().first().second;
 
             if (driverName == QByteArray("v4l2"))
-                loadMedia(QStringLiteral("v4l2://") % deviceName);
+                url = QString(QStringLiteral("v4l2://") % deviceName).toUtf8();
             else if (driverName == QByteArray("alsa"))
-                loadMedia(QStringLiteral("alsa://") % deviceName);
+                url = QString(QStringLiteral("alsa://") % deviceName).toUtf8();
             else if (driverName == "screen")
-                loadMedia(QStringLiteral("screen://") % deviceName);
+                url = QString(QStringLiteral("screen://") % deviceName).toUtf8();
             else
                 error() << Q_FUNC_INFO << "Unsupported MediaSource::CaptureDevice:" << driverName;
         }
@@ -326,9 +547,7 @@ void MediaObject::setSource(const MediaSource &source) {
         default:
             break;
     }
-
-    debug() << "Sending currentSourceChanged";
-    emit currentSourceChanged(m_mediaSource);
+    return url;
 }
 
 void MediaObject::setNextSource(const MediaSource &source) {
@@ -341,8 +560,112 @@ void MediaObject::setNextSource(const MediaSource &source) {
     // late we may already be stopped when the slot gets activated.
     // Therefore we need to make sure that we move to the next source iff
     // this function is called when we are in stoppedstate.
-    if (m_state == StoppedState)
+    if (m_state == StoppedState) {
+        m_nextQueued = false;
         moveToNext();
+        return;
+    }
+
+    // The queued source must follow the current one, not be replaced by its load.
+    issueLoad();
+
+    // Drop a previously queued source, this keeps the current entry only.
+    if(m_nextQueued)
+        m_requests.command(RequestTracker::CommandOperation, {"playlist-clear"});
+    m_nextQueued = false;
+    cancelTransition();
+    m_nextMrl = mrlForSource(source);
+    // Warm the disk for it while the current source plays, whichever way it follows.
+    if(!m_nextMrl.isEmpty())
+        m_prefetcher.prefetch({m_nextMrl});
+    // A gap is inserted after END_FILE, the source is loaded once it passed.
+    if(m_nextMrl.isEmpty() || m_transitionTime < 0)
+        return;
+
+    // Append the source to the playlist of the core now, mpv prefetches it and
+    // switches over without gap. Sources without MRL are loaded on END_FILE.
+    auto options{Backend::self->loadOptions(m_nextMrl)};
+    if(m_transitionTime > 0 && prepareCrossfade())
+        options.append({"af", "lavfi=[afade=t=in:d=" + QByteArray::number(m_transitionTime / 1000.0, 'f', 3) + "]"});
+    if(m_requests.loadfile(RequestTracker::QueueOperation, m_nextMrl, "append", options))
+        m_nextQueued = true;
+    else
+        cancelTransition();
+}
+
+bool MediaObject::prepareCrossfade() {
+    // Overlapping pictures is not supported, video sources switch gapless.
+    if(hasVideo()) {
+        debug() << "no crossfade for video, switching gapless";
+        return false;
+    }
+    const auto start{m_totalTime - m_transitionTime};
+    if(m_totalTime <= 0 || start <= m_clock.time())
+        return false;
+
+    if(!m_deck)
+        m_deck = new CrossfadeDeck(this);
+    if(!m_deck->prepare(m_mrl, start, m_transitionTime, m_audioDevice, m_observed.volume, m_observed.mute))
+        return false;
+    m_crossfadePending = true;
+    scheduleFinishSignals();
+    return true;
+}
+
+void MediaObject::startCrossfade() {
+    DEBUG_BLOCK;
+    m_crossfadePending = false;
+    if(!m_nextQueued || !m_deck->isReady()) {
+        warning() << "Crossfade tail not ready, switching gapless";
+        m_deck->cancel();
+        return;
+    }
+    // The deck continues the current source while the player moves on to the
+    // queued one, both ramps run in their filter chains.
+    m_deck->start();
+    m_handoffTimer.start();
+    m_requests.command(RequestTracker::CommandOperation, {"playlist-next"});
+}
+
+void MediaObject::cancelTransition() {
+    m_crossfadePending = false;
+    m_crossfadeTimer.stop();
+    m_gapTimer.stop();
+    m_handoffTimer.invalidate();
+    if(m_deck)
+        m_deck->cancel();
+}
+
+void MediaObject::setAudioDevice(const QByteArray& device) {
+    m_audioDevice = device;
+}
+
+qint64 MediaObject::handoffLatency() const {
+    return m_handoffLatency;
+}
+
+QObject* MediaObject::thumbnails() {
+    if(!m_thumbnails) {
+        m_thumbnails = new ThumbnailService(this);
+        m_thumbnails->setSource(m_mrl);
+    }
+    return m_thumbnails;
+}
+
+bool MediaObject::preroll() const {
+    return m_preroll;
+}
+
+void MediaObject::setPreroll(bool preroll) {
+    m_preroll = preroll;
+}
+
+qint64 MediaObject::timeToReady() const {
+    return m_timeToReady;
+}
+
+qint64 MediaObject::timeToFirstSample() const {
+    return m_timeToFirstSample;
 }
 
 qint32 MediaObject::prefinishMark() const {
@@ -353,6 +676,7 @@ void MediaObject::setPrefinishMark(qint32 msecToEnd) {
     m_prefinishMark = msecToEnd;
     if (currentTime() < totalTime() - m_prefinishMark)
         m_prefinishEmitted = false;
+    scheduleFinishSignals();
 }
 
 qint32 MediaObject::transitionTime() const {
@@ -394,6 +718,9 @@ void MediaObject::changeState(Phonon::State newState) {
     // State changed
     Phonon::State previousState = m_state;
     m_state = newState;
+    m_clock.setRunning(m_state == PlayingState);
+    updateTickTimer();
+    scheduleFinishSignals();
     emit stateChanged(m_state, previousState);
 }
 
@@ -409,18 +736,11 @@ QString MediaObject::errorString() const {
 }
 
 bool MediaObject::hasVideo() const {
-    DEBUG_BLOCK
-    if(m_mrl.isEmpty())
-        return false;
-    return mpv_get_property_string(m_player, "video-format");
+    return !m_mrl.isEmpty() && m_observed.hasVideo;
 }
 
 bool MediaObject::isSeekable() const {
-    DEBUG_BLOCK;
-    auto seekable{0};
-    if(mpv_get_property(m_player, "seekable", MPV_FORMAT_FLAG, &seekable))
-        return false;
-    return seekable;
+    return m_observed.seekable;
 }
 
 void MediaObject::updateMetaData() {
@@ -538,117 +858,118 @@ void MediaObject::refreshDescriptors() {
 }
 
 void MediaObject::mpv_event_loop() {
-    // Do not forget to register for the events you want to handle here!
+    // Do not forget to register for the events you want to handle here (HANDLED_EVENTS)!
+    // Clear the flag first, batches arriving during the drain post a new one.
+    m_drainPending = false;
+    QElapsedTimer budget;
+    budget.start();
+    auto handled{0};
+    Event event;
     while(m_player) {
-        mpv_event *event = mpv_wait_event(m_player, 0);
-        //debug() << "Event " << event->event_id;
-        switch (event->event_id) {
-            case MPV_EVENT_LOG_MESSAGE: {
-                QString msg("[");
-                msg.append(((mpv_event_log_message*)event->data)->prefix);
-                msg.append("]");
-                msg.append(((mpv_event_log_message*)event->data)->text);
-                switch(((mpv_event_log_message*)event->data)->log_level) {
+        if(handled++ >= EVENT_BUDGET || budget.nsecsElapsed() >= EVENT_TIME_BUDGET_NS) {
+            // Yield to the Qt event loop and continue with the remaining events later.
+            if(!m_drainPending.exchange(true))
+                QMetaObject::invokeMethod(this, &MediaObject::mpv_event_loop, Qt::QueuedConnection);
+            break;
+        }
+        if(!m_events.events.pop(event))
+            break;
+        //debug() << "Event " << event.id;
+        switch (event.id) {
+            case MPV_EVENT_LOG_MESSAGE:
+                switch(event.logLevel) {
                     case MPV_LOG_LEVEL_FATAL:
-                        fatal() << msg;
+                        fatal() << event.text;
                         break;
                     case MPV_LOG_LEVEL_ERROR:
-                        error() << msg;
+                        error() << event.text;
                         break;
                     case MPV_LOG_LEVEL_WARN:
-                        warning() << msg;
+                        warning() << event.text;
                         break;
                     case MPV_LOG_LEVEL_INFO:
                     case MPV_LOG_LEVEL_V:
-                        debug() << msg;
+                        debug() << event.text;
                         break;
                     default:
                         break;
                 }
-            }
-            break;
+                break;
             case MPV_EVENT_PROPERTY_CHANGE:
-                //debug() << "Changed Property " << event->reply_userdata;
-                switch(event->reply_userdata) {
-                    case 0:
-                        if(((mpv_event_property*)event->data)->format)
-                            timeChanged(static_cast<qint64>(*(double*)((mpv_event_property*)event->data)->data * 1000));
-                        break;
-                    case 1:
-                        if(((mpv_event_property*)event->data)->format)
-                            seekableChanged(static_cast<bool>(*(int*)((mpv_event_property*)event->data)->data));
-                        break;
-                    case 2:
-                        if(((mpv_event_property*)event->data)->format) {
-                            m_totalTime = static_cast<qint64>(*(double*)((mpv_event_property*)event->data)->data * 1000);
-                            emit totalTimeChanged(m_totalTime);
-                        }
-                        break;
-                    case 3:
-                        if(((mpv_event_property*)event->data)->format) {
-                            if(*(int*)((mpv_event_property*)event->data)->data) {
-                                m_buffering = true;
-                                if(m_state != BufferingState) {
-                                    m_stateAfterBuffering = m_state;
-                                    changeState(BufferingState);
-                                }
-                                mpv_observe_property(m_player, 4, "cache-buffering-state", MPV_FORMAT_INT64);
-                            } else if(m_buffering) {
-                                m_buffering = false;
-                                changeState(m_stateAfterBuffering);
-                                mpv_unobserve_property(m_player, 4);
-                            }
-                        }
-                        break;
-                    case 4:
-                        if(((mpv_event_property*)event->data)->format)
-                            emit bufferStatus(static_cast<int>(*(int64_t*)((mpv_event_property*)event->data)->data));
-                        break;
-                    case 5:
-                        if(((mpv_event_property*)event->data)->format) {
-                            if(*(int*)((mpv_event_property*)event->data)->data)
-                                updateState(PausedState);
-                            else if(m_state != PlayingState)
-                                updateState(PlayingState);
-                        }
-                        break;
-                    case 7:
-                        if(((mpv_event_property*)event->data)->format) {
-                            if((char*)((mpv_event_property*)event->data)->data)
-                                hasVideoChanged(true);
-                            else
-                                hasVideoChanged(false);
-                        }
-                        break;
-                    case 8:
-                        if(((mpv_event_property*)event->data)->format)
-                            updateMetaData();
-                        break;
-                    case 9:
-                        if(((mpv_event_property*)event->data)->format)
-                            emit mutedChanged(*(int*)((mpv_event_property*)event->data)->data != 0);
-                        break;
-                    case 10:
-                        if(((mpv_event_property*)event->data)->format)
-                            emit volumeChanged(*(int64_t*)((mpv_event_property*)event->data)->data);
-                        break;
-                }
+                //debug() << "Changed Property " << event.userdata;
+                m_properties.dispatch(this, event);
                 break;
             case MPV_EVENT_START_FILE:
+                if(m_nextQueued && m_playlistEntry >= 0 && event.entry != m_playlistEntry) {
+                    // A gapless switch to the queued source keeps playing.
+                    m_playlistEntry = event.entry;
+                    switchToQueued();
+                    break;
+                }
+                m_playlistEntry = event.entry;
                 updateState(LoadingState);
                 break;
             case MPV_EVENT_FILE_LOADED:
+                m_probeHinted = false;
                 refreshDescriptors();
-                updateState(PlayingState);
+                // A pre-rolled source is ready once decoded, see PLAYBACK_RESTART.
+                if(!m_prerolling && !m_pauseOnReady)
+                    updateState(PlayingState);
                 break;
-            case MPV_EVENT_COMMAND_REPLY: 
-                if(event->error < 0)
-                    updateState(ErrorState);
+            case MPV_EVENT_PLAYBACK_RESTART:
+                if((m_prerolling || m_pauseOnReady) && m_state == LoadingState) {
+                    // Paused with the audio buffer filled and the first frame decoded.
+                    m_timeToReady = m_openTimer.elapsed();
+                    debug() << "pre-roll ready after" << m_timeToReady << "ms";
+                    updateState(m_pauseOnReady ? PausedState : StoppedState);
+                    m_pauseOnReady = false;
+                }
+                if(m_openTimer.isValid()) {
+                    // First restart after loadfile, the source is open and decoding.
+                    Backend::self->recordOpenLatency(m_mrl, m_openTimer.elapsed());
+                    m_openTimer.invalidate();
+                }
+                if(m_handoffTimer.isValid()) {
+                    // The next source plays, the crossfade handoff is complete.
+                    m_handoffLatency = m_handoffTimer.elapsed();
+                    m_handoffTimer.invalidate();
+                    debug() << "crossfade handoff took" << m_handoffLatency << "ms";
+                }
+                if(m_seeking) {
+                    seekLanded();
+                } else {
+                    // The position jumped without seek(), e.g. a chapter change or a seek
+                    // from mpv itself. The timers were armed for the old position.
+                    rearmFinishSignals();
+                }
+                // The clock may still hold the old position, re-arm from the next update.
+                m_rearmOnTimePos = true;
+                break;
+            case MPV_EVENT_COMMAND_REPLY:
+            case MPV_EVENT_SET_PROPERTY_REPLY:
+                requestFinished(event);
                 break;
             case MPV_EVENT_END_FILE:
+                // Entries that were switched away from or replaced already were dealt with.
+                if(event.entry != m_playlistEntry)
+                    break;
+                if(m_probeHinted && event.value.i == MPV_END_FILE_REASON_ERROR) {
+                    // The recorded demuxer did not open the source, probe it from scratch.
+                    warning() << "Stale probe hint for" << m_mrl << ", reopening";
+                    Backend::self->probeCache().forget(m_mrl);
+                    m_seekpoint = m_loadStart;
+                    m_loadPending = true;
+                    issueLoad();
+                    break;
+                }
                 if(m_state != StoppedState) {
-                    if(m_nextSource.type() != MediaSource::Invalid && m_nextSource.type() != MediaSource::Empty) {
-                        moveToNextSource();
+                    if(m_nextQueued) {
+                        // mpv continues with the queued source, see switchToQueued().
+                    } else if(m_nextSource.type() != MediaSource::Invalid && m_nextSource.type() != MediaSource::Empty) {
+                        if(m_transitionTime < 0)
+                            m_gapTimer.start(-m_transitionTime);
+                        else
+                            moveToNextSource();
                     } else if(source().discType() == Cd && m_autoPlayTitles && !m_attemptingAutoplay) {
                         debug() << "trying to simulate autoplay";
                         m_attemptingAutoplay = true;
@@ -667,13 +988,176 @@ void MediaObject::mpv_event_loop() {
             default:
                 break;
         }
-        if(event->event_id == MPV_EVENT_NONE)
+    }
+    // The dispatcher stops draining a client whose queue ran full.
+    if(m_events.stalled)
+        Backend::self->dispatcher()->resume();
+}
+
+void MediaObject::requestFinished(const Event& event) {
+    RequestTracker::Request request;
+    if(!m_requests.finish(event.userdata, &request))
+        return;
+    MediaController::requestFinished(event.userdata, request, event.error >= 0);
+    if(event.error >= 0)
+        return;
+    switch(request.operation) {
+        case RequestTracker::LoadOperation:
+            error() << "Failed to load media:" << mpv_error_string(event.error);
+            updateState(ErrorState);
+            break;
+        case RequestTracker::QueueOperation:
+            warning() << "Failed to queue next source:" << mpv_error_string(event.error);
+            // Load it once the current source ended instead.
+            m_nextQueued = false;
+            cancelTransition();
             break;
+        case RequestTracker::StopOperation:
+            error() << "Failed to stop media:" << mpv_error_string(event.error);
+            break;
+        case RequestTracker::SeekOperation:
+            warning() << "Failed to seek:" << mpv_error_string(event.error);
+            // There will be no playback restart for this seek.
+            m_scrubbing = false;
+            seekLanded();
+            break;
+        case RequestTracker::PropertyOperation:
+            warning() << "Failed to set" << request.name << ":" << mpv_error_string(event.error);
+            break;
+        case RequestTracker::CommandOperation:
+            warning() << "Failed to run" << request.name << ":" << mpv_error_string(event.error);
+            break;
+    }
+}
+
+void MediaObject::attachProperty(Property property) {
+    m_properties.attach(m_player, property);
+}
+
+void MediaObject::detachProperty(Property property) {
+    m_properties.detach(m_player, property);
+}
+
+void MediaObject::onTimePos(double time) {
+    if(m_firstSampleTimer.isValid() && m_state == PlayingState && !m_observed.paused) {
+        m_timeToFirstSample = m_firstSampleTimer.elapsed();
+        m_firstSampleTimer.invalidate();
+        debug() << "first sample after" << m_timeToFirstSample << "ms";
     }
+    m_clock.update(time);
+    if(m_rearmOnTimePos) {
+        m_rearmOnTimePos = false;
+        rearmFinishSignals();
+    }
+    timeChanged(static_cast<qint64>(time * 1000));
+}
+
+void MediaObject::onSeekable(bool seekable) {
+    m_observed.seekable = seekable;
+    emit seekableChanged(seekable);
+}
+
+void MediaObject::onDuration(double duration) {
+    m_totalTime = static_cast<qint64>(duration * 1000);
+    scheduleFinishSignals();
+    emit totalTimeChanged(m_totalTime);
+}
+
+void MediaObject::onPausedForCache(bool paused) {
+    m_observed.pausedForCache = paused;
+    if(paused) {
+        m_buffering = true;
+        if(m_state != BufferingState) {
+            m_stateAfterBuffering = m_state;
+            changeState(BufferingState);
+        }
+        attachProperty(CacheBufferingStateProperty);
+    } else if(m_buffering) {
+        m_buffering = false;
+        changeState(m_stateAfterBuffering);
+        detachProperty(CacheBufferingStateProperty);
+    }
+}
+
+void MediaObject::onCacheBufferingState(qint64 percent) {
+    emit bufferStatus(static_cast<int>(percent));
+}
+
+void MediaObject::onPause(bool paused) {
+    m_observed.paused = paused;
+    if(m_deck)
+        m_deck->setPaused(paused);
+    if(m_prerolling || m_pauseOnReady)
+        return;
+    if(paused)
+        updateState(PausedState);
+    else if(m_state != PlayingState)
+        updateState(PlayingState);
+}
+
+void MediaObject::onCurrentVo(const QByteArray& vo) {
+    emit hasVideoChanged(!vo.isEmpty());
+}
+
+void MediaObject::onMetadata() {
+    updateMetaData();
+}
+
+void MediaObject::onMute(bool mute) {
+    m_observed.mute = mute;
+    emit mutedChanged(mute);
+}
+
+void MediaObject::onVolume(double volume) {
+    m_observed.volume = volume;
+    // Phonon volumes are factors, mpv uses percent
+    emit volumeChanged(volume / 100.0);
+}
+
+void MediaObject::onSpeed(double speed) {
+    m_observed.speed = speed;
+    m_clock.setSpeed(speed);
+    scheduleFinishSignals();
+}
+
+void MediaObject::onVideoFormat(const QByteArray& format) {
+    m_observed.hasVideo = !format.isEmpty();
+}
+
+void MediaObject::onCurrentDemuxer(const QByteArray& demuxer) {
+    m_observed.demuxer = demuxer;
+    recordProbe();
+}
+
+void MediaObject::onFileFormat(const QByteArray& format) {
+    m_observed.fileFormat = format;
+    recordProbe();
+}
+
+void MediaObject::switchToQueued() {
+    debug() << "gapless switch to" << m_nextMrl;
+    m_nextQueued = false;
+    // Queued sources are loaded without probe hints.
+    m_probeHinted = false;
+    m_mediaSource = m_nextSource;
+    m_mrl = m_nextMrl;
+    m_nextSource = MediaSource(QUrl());
+    if(m_thumbnails)
+        m_thumbnails->setSource(m_mrl);
+    // Drop the finished entry, the playlist only holds the current and the queued source.
+    m_requests.command(RequestTracker::CommandOperation, {"playlist-remove", "0"});
+
+    m_totalTime = -1;
+    m_prefinishEmitted = false;
+    m_aboutToFinishEmitted = false;
+    m_clock.reset();
+    // Playback goes on without a state change, changeState() does not restart the clock.
+    m_clock.setRunning(m_state == PlayingState);
+    scheduleFinishSignals();
+    emit currentSourceChanged(m_mediaSource);
 }
 
 qint64 MediaObject::totalTime() const {
-    DEBUG_BLOCK;
     return m_totalTime;
 }
 
@@ -22,18 +22,41 @@
 #ifndef PHONON_MPV_MEDIAOBJECT_H
 #define PHONON_MPV_MEDIAOBJECT_H
 
+#include <QElapsedTimer>
 #include <QObject>
 #include <QTimer>
 
+#include <atomic>
+
 #include <phonon/mediaobjectinterface.h>
 #include <phonon/addoninterface.h>
 
+#include "eventdispatcher.h"
 #include "mediacontroller.h"
+#include "playbackclock.h"
+#include "prefetcher.h"
+#include "propertyregistry.h"
 
 namespace Phonon::MPV {
 
+    class CrossfadeDeck;
+    class ThumbnailService;
     class SinkNode;
 
+    /// Latest values of the observed mpv properties of a player, updated from its event stream.
+    struct ObservedState {
+        bool seekable{false};
+        bool pausedForCache{false};
+        bool paused{false};
+        bool hasVideo{false};
+        bool mute{false};
+        double volume{100.0};
+        double speed{1.0};
+        /// current-demuxer and file-format of the current source, empty while opening
+        QByteArray demuxer;
+        QByteArray fileFormat;
+    };
+
     /** \brief Implementation for the most important class in Phonon
     *
     * The MediaObject class is the workhorse for Phonon. It handles what is needed
@@ -61,9 +84,36 @@ namespace Phonon::MPV {
     class MediaObject : public QObject, public MediaObjectInterface, public MediaController {
         Q_OBJECT
         Q_INTERFACES(Phonon::MediaObjectInterface Phonon::AddonInterface)
+        /// Time in ms from the start of the last crossfade until the next source played, -1 if none happened yet
+        Q_PROPERTY(qint64 handoffLatency READ handoffLatency)
+        /// Whether setSource() loads paused into StoppedState instead of playing, see setPreroll()
+        Q_PROPERTY(bool preroll READ preroll WRITE setPreroll)
+        /// Time in ms from the last pre-rolled load until it was ready to play, -1 if none happened yet
+        Q_PROPERTY(qint64 timeToReady READ timeToReady)
+        /// Time in ms from the last play request until playback advanced, -1 if none happened yet
+        Q_PROPERTY(qint64 timeToFirstSample READ timeToFirstSample)
         friend class SinkNode;
 
     public:
+        /// Observable mpv properties, the value is the index into the property table.
+        enum Property {
+            TimePosProperty,
+            SeekableProperty,
+            DurationProperty,
+            PausedForCacheProperty,
+            CacheBufferingStateProperty,
+            PauseProperty,
+            CurrentVoProperty,
+            MetadataProperty,
+            MuteProperty,
+            VolumeProperty,
+            SpeedProperty,
+            VideoFormatProperty,
+            CurrentDemuxerProperty,
+            FileFormatProperty,
+            PropertyCount
+        };
+
         /**
         * Initializes the members, connects the private slots to their corresponding signals,
         * sets the next media source to an empty media source.
@@ -117,8 +167,10 @@ namespace Phonon::MPV {
         void removeSink(SinkNode* node);
 
         /**
-        * Pushes a seek command to the SeekStack for this media object. The SeekStack then
-        * calls seekInternal() when it's popped.
+        * Seeks to \p milliseconds. While a seek is running only the latest target is kept
+        * (scrubbing), intermediate targets are approached with fast keyframe seeks and a final
+        * exact seek follows once no new targets arrive. seekCompleted() is emitted once the
+        * seek landed.
         */
         void seek(qint64 milliseconds) Q_DECL_OVERRIDE;
 
@@ -138,6 +190,7 @@ namespace Phonon::MPV {
         * \return The current time of the media, depending on the current state.
         * If the current state is stopped or loading, 0 is returned.
         * If the current state is error or unknown, -1 is returned.
+        * The time is interpolated from the last observed position and never calls into libmpv.
         */
         qint64 currentTime() const Q_DECL_OVERRIDE;
 
@@ -169,15 +222,60 @@ namespace Phonon::MPV {
         */
         void setSource(const MediaSource &source) Q_DECL_OVERRIDE;
 
-        /// Sets the media source that will replace the current one, after the playback for it finishes.
+        /**
+        * Sets the media source that will replace the current one, after the playback for it finishes.
+        * The source is appended to the playlist of the core right away, so mpv can prefetch it and
+        * continue without gap. The switch is picked up from the START_FILE of its entry.
+        */
         void setNextSource(const MediaSource &source) Q_DECL_OVERRIDE;
 
         qint32 prefinishMark() const Q_DECL_OVERRIDE;
         void setPrefinishMark(qint32 msecToEnd) Q_DECL_OVERRIDE;
 
         qint32 transitionTime() const Q_DECL_OVERRIDE;
+        /**
+        * Sets how sources queued with setNextSource() follow each other: 0 switches gapless,
+        * a positive time crossfades for that long and a negative time inserts a gap of silence.
+        */
         void setTransitionTime(qint32) Q_DECL_OVERRIDE;
 
+        qint64 handoffLatency() const;
+
+        /// Mirrors the audio-device AudioOutput set, the crossfade deck plays on the same device.
+        void setAudioDevice(const QByteArray& device);
+
+        /**
+        * \return The seek bar thumbnails of the current source, rendered on a shadow core of
+        * their own. Created on first use, applications reach it through the meta object system.
+        */
+        Q_INVOKABLE QObject* thumbnails();
+
+        bool preroll() const;
+        /**
+        * Enables pre-rolling: setSource() opens the source paused, fills the audio buffer and
+        * decodes the first frame, then reports StoppedState. play() only has to unpause.
+        * Defaults to the PHONON_MPV_PREROLL environment variable.
+        */
+        void setPreroll(bool preroll);
+        qint64 timeToReady() const;
+        qint64 timeToFirstSample() const;
+
+        /**
+        * Starts observing \p property for a sink that needs it. Attaching is reference
+        * counted, every attachProperty() needs a matching detachProperty().
+        */
+        void attachProperty(Property property);
+        void detachProperty(Property property);
+
+        /**
+        * \return The mirror of the observed properties. Values of properties nobody
+        * is attached to are not updated.
+        */
+        inline const ObservedState& observed() const { return m_observed; }
+
+        /// \return The tracker for asynchronous commands and property writes on player().
+        inline RequestTracker& requests() { return m_requests; }
+
         void emitAboutToFinish();
         void loadMedia(const QString& mrl);
         static void event_cb(void *opaque);
@@ -212,6 +310,9 @@ namespace Phonon::MPV {
 
         void moveToNext();
 
+        /// Emitted when playback restarted after the last seek, at \p time.
+        void seekCompleted(qint64 time);
+
     private Q_SLOTS:
         /**
         * If the new state is different from the current state, the current state is
@@ -220,13 +321,20 @@ namespace Phonon::MPV {
         void changeState(Phonon::State newState);
 
         /**
-        * Checks when the tick(), prefinishMarkReached(), aboutToFinish() signals need to
-        * be emitted and emits them if necessary.
+        * Emits tick() for position changes while paused, playing ticks come from m_tickTimer.
         *
         * \param currentTime The current play time for the media, in miliseconds.
         */
         void timeChanged(qint64 time);
-        void emitTick(qint64 time);
+
+        /// Emits tick() with the interpolated time, driven by m_tickTimer.
+        void emitTick();
+
+        /// Emits prefinishMarkReached() once, driven by m_prefinishTimer.
+        void emitPrefinishMark();
+
+        /// Starts the prepared tail on m_deck and moves the player on to the queued source.
+        void startCrossfade();
 
         /**
         * If the next media source is valid, the current source is replaced and playback is commenced.
@@ -245,10 +353,89 @@ namespace Phonon::MPV {
 
         /** Refreshes all MediaController descriptors if Video is present. */
         void refreshDescriptors();
+        /**
+        * Drains events the EventDispatcher queued for m_player. A single drain is limited to a small event and
+        * time budget, remaining events are handled in a follow-up drain so the GUI
+        * thread never stalls on bursts of property changes or log messages.
+        */
         void mpv_event_loop();
 
     private:
+        /// \return The MRL mpv plays \p source from, empty if the source can not be loaded by URL.
+        QByteArray mrlForSource(const MediaSource& source) const;
+
+        /**
+        * Opens the tail of the current source on m_deck for a crossfade into the queued source.
+        * \return \c false if the source is not suited, the sources then switch gapless.
+        */
+        bool prepareCrossfade();
+
+        /// Drops a pending crossfade or gap.
+        void cancelTransition();
+
+        /// Sends the loadfile of loadMedia(), a stored seek point becomes its start option.
+        void issueLoad();
+
+        /// Stores the demuxer the current source opened with in the backend's ProbeCache.
+        void recordProbe();
+
+        /// Issues a keyframe (\p fast) or an exact seek.
+        void startSeek(qint64 milliseconds, bool fast);
+
+        /// Called when a seek landed, continues scrubbing or finishes the seek.
+        void seekLanded();
+
+        /// Completes the request of a reply event and reports errors for the operation it belongs to.
+        void requestFinished(const Event& event);
+
+        // Property handlers, see s_properties
+        void onTimePos(double time);
+        void onSeekable(bool seekable);
+        void onDuration(double duration);
+        void onPausedForCache(bool paused);
+        void onCacheBufferingState(qint64 percent);
+        void onPause(bool paused);
+        void onCurrentVo(const QByteArray& vo);
+        void onMetadata();
+        void onMute(bool mute);
+        void onVolume(double volume);
+        void onSpeed(double speed);
+        void onVideoFormat(const QByteArray& format);
+        void onCurrentDemuxer(const QByteArray& demuxer);
+        void onFileFormat(const QByteArray& format);
+
+        /// Makes the queued source current once mpv started it.
+        void switchToQueued();
+
+        /// \return The aboutToFinish() lead for the next source, see Backend::aboutToFinishLead().
+        qint64 aboutToFinishLead() const;
+
+        /// Runs m_tickTimer at m_tickInterval while playing.
+        void updateTickTimer();
+
+        /**
+        * (Re)starts the one-shot timers of aboutToFinish() and prefinishMarkReached() from the
+        * interpolated clock. Called whenever the remaining time jumps, i.e. on state, duration,
+        * speed, prefinish mark and source changes and after seeks and playback restarts.
+        */
+        void scheduleFinishSignals();
+        /// Clears the emitted flags of signals still ahead of the position and schedules them again.
+        void rearmFinishSignals();
+
+        static const PropertyBinding<MediaObject> s_properties[PropertyCount];
+        PropertyRegistry<MediaObject, PropertyCount> m_properties;
+        /// Core of this player from the backend's CorePool, m_player is a client of it
+        mpv_handle* m_core;
+        ObservedState m_observed;
+
         MediaSource m_nextSource;
+        QByteArray m_nextMrl;
+        /// Warms the page cache for m_nextMrl
+        Prefetcher m_prefetcher;
+        /// m_nextSource is appended to the playlist of the core
+        bool m_nextQueued;
+        /// playlist_entry_id of the current source, -1 until mpv started it
+        qint64 m_playlistEntry;
 
         MediaSource m_mediaSource;
         Phonon::State m_state;
@@ -257,10 +444,45 @@ namespace Phonon::MPV {
         bool m_prefinishEmitted;
 
         bool m_aboutToFinishEmitted;
+        QTimer m_aboutToFinishTimer;
+        QTimer m_prefinishTimer;
+        /// Runs from loadfile to the first playback restart, see Backend::recordOpenLatency()
+        QElapsedTimer m_openTimer;
 
         qint32 m_tickInterval;
-        qint64 m_lastTick;
+        QTimer m_tickTimer;
+        PlaybackClock m_clock;
         qint32 m_transitionTime;
+        CrossfadeDeck* m_deck;
+        /// The tail is prepared on m_deck, m_crossfadeTimer starts it
+        bool m_crossfadePending;
+        /// Set by a playback restart, the next position update re-arms the finish signals
+        bool m_rearmOnTimePos;
+        QTimer m_crossfadeTimer;
+        /// Delays moveToNextSource() for negative transition times
+        QTimer m_gapTimer;
+        /// Runs from the start of a crossfade until the next source played
+        QElapsedTimer m_handoffTimer;
+        qint64 m_handoffLatency;
+        /// See setAudioDevice(), empty for mpv's default
+        QByteArray m_audioDevice;
+        ThumbnailService* m_thumbnails;
+
+        bool m_preroll;
+        /// The current source was loaded paused and play() was not called yet
+        bool m_prerolling;
+        /// pause() was called while the pre-rolled source was still opening
+        bool m_pauseOnReady;
+        /// loadMedia() queued issueLoad()
+        bool m_loadPending;
+        /// The loadfile carried ProbeCache hints, until the file loaded
+        bool m_probeHinted;
+        /// Start position of the last loadfile, reused when it is retried without hints
+        qint64 m_loadStart;
+        /// Runs from a play request until playback advanced
+        QElapsedTimer m_firstSampleTimer;
+        qint64 m_timeToReady;
+        qint64 m_timeToFirstSample;
 
         qint64 m_totalTime;
         QByteArray m_mrl;
@@ -271,13 +493,27 @@ namespace Phonon::MPV {
 
         /**
         * Workaround for being able to seek before VLC goes to playing state.
-        * Seeks before playing are stored in this var, and processed on state change
-        * to Playing.
+        * Seeks before playing are stored in this var. Until the loadfile went out they
+        * become its start option, later ones are processed on state change to Playing.
         */
         qint64 m_seekpoint;
 
+        /// A seek command is running, until MPV_EVENT_PLAYBACK_RESTART
+        bool m_seeking;
+        /// The running seek is a keyframe seek, an exact one follows when scrubbing ends
+        bool m_scrubbing;
+        qint64 m_seekTarget;
+        /// Latest target that arrived while seeking, -1 if none
+        qint64 m_pendingSeek;
+
         bool m_buffering;
         Phonon::State m_stateAfterBuffering;
+
+        /// Events of m_player, filled by the backend's EventDispatcher
+        EventQueue m_events;
+
+        /// Set while a drain of m_events is queued on the GUI thread.
+        std::atomic<bool> m_drainPending;
     };
 
 } // namespace Phonon::MPV
@@ -0,0 +1,261 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mediascanner.h"
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+
+#define MPV_ENABLE_DEPRECATED 0
+#include <mpv/client.h>
+
+#include <cstring>
+
+#include "corepool.h"
+#include "utils/debug.h"
+#include "utils/events.h"
+
+// Time a file may take until the demuxer reported its streams
+static const qint64 SCAN_TIMEOUT = 10000;
+// Seconds mpv_wait_event() blocks before cancellation is checked
+static const double WAIT_INTERVAL = 0.1;
+
+using namespace Phonon::MPV;
+
+MediaScanner::MediaScanner(int capacity, int threads, QObject* parent)
+    : QObject(parent)
+    , m_active(0)
+    , m_running(0)
+    , m_capacity(capacity)
+    , m_generation(0) {
+    m_workers.setMaxThreadCount(threads > 0 ? threads : QThread::idealThreadCount());
+}
+
+MediaScanner::~MediaScanner() {
+    cancel();
+    m_workers.waitForDone();
+    for(auto core : m_idle)
+        mpv_terminate_destroy(core);
+}
+
+bool MediaScanner::enqueue(const QUrl& url) {
+    QMutexLocker locker(&m_lock);
+    if(m_queue.size() >= m_capacity)
+        return false;
+    m_queue.enqueue(url);
+    if(m_running < m_workers.maxThreadCount()) {
+        m_running++;
+        m_workers.start([this] { work(); });
+    }
+    return true;
+}
+
+void MediaScanner::cancel() {
+    QMutexLocker locker(&m_lock);
+    ++m_generation;
+    m_queue.clear();
+}
+
+int MediaScanner::pending() const {
+    QMutexLocker locker(&m_lock);
+    return m_queue.size() + m_active;
+}
+
+QUrl MediaScanner::next(bool* last) {
+    QMutexLocker locker(&m_lock);
+    if(m_queue.isEmpty()) {
+        // Decided under the lock, enqueue() starts a worker for anything queued after this.
+        *last = !--m_running;
+        return QUrl();
+    }
+    m_active++;
+    return m_queue.dequeue();
+}
+
+void MediaScanner::work() {
+    auto core{takeCore()};
+    auto last{false};
+    forever {
+        const auto generation{m_generation.load()};
+        const auto url{next(&last)};
+        if(url.isEmpty())
+            break;
+        QVariantMap result;
+        if(core)
+            result = scan(core, url, generation);
+        else
+            result.insert(QStringLiteral("error"), QStringLiteral("Failed to create a scanning core"));
+        {
+            QMutexLocker locker(&m_lock);
+            m_active--;
+        }
+        if(generation == m_generation)
+            emit scanned(url, result);
+    }
+
+    if(core) {
+        QMutexLocker locker(&m_lock);
+        m_idle.append(core);
+    }
+    // Only the worker that left the others done reports it.
+    if(last)
+        emit finished();
+}
+
+mpv_handle* MediaScanner::takeCore() {
+    {
+        QMutexLocker locker(&m_lock);
+        if(!m_idle.isEmpty())
+            return m_idle.takeLast();
+    }
+    return createCore();
+}
+
+mpv_handle* MediaScanner::createCore() {
+    // No tracks selected, the demuxer alone reports what the scan returns.
+    const auto core{createHeadlessCore("scanning", {
+        {"vid", "no"},
+        {"aid", "no"},
+        {"cache", "no"},
+        {"pause", "yes"},
+    })};
+    // The worker waits for these only.
+    if(core)
+        requestEvents(core, {MPV_EVENT_FILE_LOADED, MPV_EVENT_END_FILE});
+    return core;
+}
+
+QVariantMap MediaScanner::scan(mpv_handle* core, const QUrl& url, quint64 generation) {
+    QVariantMap result;
+    const auto mrl{url.scheme().isEmpty() ? QUrl::fromLocalFile(url.path()).toEncoded() : url.toEncoded()};
+    const char* load[]{"loadfile", mrl.constData(), nullptr};
+    auto err{0};
+    if((err = mpv_command(core, load)) < 0) {
+        result.insert(QStringLiteral("error"), QString::fromUtf8(mpv_error_string(err)));
+        return result;
+    }
+
+    // Wait until the demuxer reported the streams, or the file failed to open.
+    QElapsedTimer timer;
+    timer.start();
+    auto loaded{false}, ended{false};
+    while(!loaded && !ended) {
+        if(generation != m_generation || timer.elapsed() > SCAN_TIMEOUT) {
+            result.insert(QStringLiteral("error"), generation != m_generation ? QStringLiteral("Cancelled")
+                                                                            : QStringLiteral("Timed out"));
+            break;
+        }
+        const auto event{mpv_wait_event(core, WAIT_INTERVAL)};
+        if(event->event_id == MPV_EVENT_FILE_LOADED) {
+            loaded = true;
+        } else if(event->event_id == MPV_EVENT_END_FILE) {
+            const auto end{static_cast<mpv_event_end_file*>(event->data)};
+            if(end->reason == MPV_END_FILE_REASON_REDIRECT) {
+                // A playlist, mpv goes on with its first entry, which is what gets reported.
+                result.insert(QStringLiteral("redirected"), true);
+                continue;
+            }
+            ended = true;
+            if(end->reason == MPV_END_FILE_REASON_ERROR)
+                result.insert(QStringLiteral("error"), QString::fromUtf8(mpv_error_string(end->error)));
+        }
+    }
+
+    if(loaded) {
+        char* format{mpv_get_property_string(core, "file-format")};
+        if(format) {
+            result.insert(QStringLiteral("format"), QString::fromUtf8(format));
+            mpv_free(format);
+        }
+
+        double duration{-1};
+        mpv_get_property(core, "duration", MPV_FORMAT_DOUBLE, &duration);
+        result.insert(QStringLiteral("duration"), duration >= 0 ? static_cast<qint64>(duration * 1000) : qint64(-1));
+
+        int64_t chapters{0};
+        mpv_get_property(core, "chapters", MPV_FORMAT_INT64, &chapters);
+        result.insert(QStringLiteral("chapters"), static_cast<int>(chapters));
+
+        mpv_node node;
+        if(mpv_get_property(core, "metadata", MPV_FORMAT_NODE, &node) >= 0) {
+            QVariantMap metaData;
+            if(node.format == MPV_FORMAT_NODE_MAP) {
+                for(auto i{0}; i < node.u.list->num; i++) {
+                    if(node.u.list->values[i].format == MPV_FORMAT_STRING)
+                        metaData.insert(QString::fromUtf8(node.u.list->keys[i]).toUpper(),
+                                        QString::fromUtf8(node.u.list->values[i].u.string));
+                }
+            }
+            result.insert(QStringLiteral("metaData"), metaData);
+            mpv_free_node_contents(&node);
+        }
+
+        QStringList audioCodecs, videoCodecs;
+        int64_t width{0}, height{0};
+        if(mpv_get_property(core, "track-list", MPV_FORMAT_NODE, &node) >= 0) {
+            for(auto i{0}; node.format == MPV_FORMAT_NODE_ARRAY && i < node.u.list->num; i++) {
+                const auto& track{node.u.list->values[i]};
+                if(track.format != MPV_FORMAT_NODE_MAP)
+                    continue;
+                const char* type{nullptr};
+                const char* codec{nullptr};
+                int64_t trackWidth{0}, trackHeight{0};
+                auto image{false};
+                for(auto j{0}; j < track.u.list->num; j++) {
+                    const auto key{track.u.list->keys[j]};
+                    const auto& value{track.u.list->values[j]};
+                    if(!strcmp(key, "type") && value.format == MPV_FORMAT_STRING)
+                        type = value.u.string;
+                    else if(!strcmp(key, "codec") && value.format == MPV_FORMAT_STRING)
+                        codec = value.u.string;
+                    else if(!strcmp(key, "demux-w") && value.format == MPV_FORMAT_INT64)
+                        trackWidth = value.u.int64;
+                    else if(!strcmp(key, "demux-h") && value.format == MPV_FORMAT_INT64)
+                        trackHeight = value.u.int64;
+                    else if(!strcmp(key, "image") && value.format == MPV_FORMAT_FLAG)
+                        image = value.u.flag;
+                }
+                if(!type || !codec)
+                    continue;
+                if(!strcmp(type, "audio")) {
+                    audioCodecs.append(QString::fromUtf8(codec));
+                } else if(!strcmp(type, "video") && !image) {
+                    // Cover art is no video stream.
+                    videoCodecs.append(QString::fromUtf8(codec));
+                    if(!width) {
+                        width = trackWidth;
+                        height = trackHeight;
+                    }
+                }
+            }
+            mpv_free_node_contents(&node);
+        }
+        result.insert(QStringLiteral("audioCodecs"), audioCodecs);
+        result.insert(QStringLiteral("videoCodecs"), videoCodecs);
+        result.insert(QStringLiteral("width"), static_cast<int>(width));
+        result.insert(QStringLiteral("height"), static_cast<int>(height));
+    }
+
+    if(!ended) {
+        // The END_FILE of this file must not be taken for one of the next.
+        const char* stop[]{"stop", nullptr};
+        mpv_command(core, stop);
+        while(mpv_wait_event(core, WAIT_INTERVAL)->event_id != MPV_EVENT_END_FILE && timer.elapsed() < 2 * SCAN_TIMEOUT) {}
+    }
+    return result;
+}
@@ -0,0 +1,111 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_MPV_MEDIASCANNER_H
+#define PHONON_MPV_MEDIASCANNER_H
+
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QQueue>
+#include <QThreadPool>
+#include <QUrl>
+#include <QVariantMap>
+
+#include <atomic>
+
+struct mpv_handle;
+
+namespace Phonon::MPV {
+
+    /** \brief Reads tags, duration and stream layout of many files in parallel
+    *
+    * Opening files through a MediaObject to learn about them is serial and sets up outputs
+    * and decoders. The scanner instead fans out over one worker per CPU, each with a core
+    * of its own that has no outputs and selects no tracks, so nothing is decoded. A file
+    * is opened until the demuxer reported its streams, then dropped again.
+    *
+    * The scanner lives in the backend, see Backend::mediaScanner(). Applications reach it
+    * through the meta object system and get results as QVariantMap, so they need none of
+    * the backend's headers.
+    */
+    class MediaScanner : public QObject {
+        Q_OBJECT
+        /// URLs queued or being scanned
+        Q_PROPERTY(int pending READ pending)
+
+    public:
+        /// At most \p capacity URLs are queued, \p threads workers scan at once (0: one per CPU).
+        explicit MediaScanner(int capacity = 1024, int threads = 0, QObject* parent = nullptr);
+        ~MediaScanner() Q_DECL_OVERRIDE;
+
+        /**
+        * Queues \p url for scanning.
+        * \return \c false if the queue is full, retry once results came in.
+        */
+        Q_INVOKABLE bool enqueue(const QUrl& url);
+
+        /// Drops queued URLs and aborts running scans, their results are not reported.
+        Q_INVOKABLE void cancel();
+
+        int pending() const;
+
+    Q_SIGNALS:
+        /**
+        * Reports the scan of \p url, from a worker thread. \p result holds "error" if it
+        * failed, otherwise "format", "duration" in ms (-1 if unknown), "metaData" (QVariantMap),
+        * "audioCodecs", "videoCodecs", "width", "height" and "chapters". Playlists report their
+        * first entry and "redirected". A file that ended without opening and without error
+        * reports none of these.
+        */
+        void scanned(const QUrl& url, const QVariantMap& result);
+
+        /// The queue ran empty and all workers are idle.
+        void finished();
+
+    private:
+        /// Runs on m_workers, scans queued URLs until the queue is empty.
+        void work();
+
+        /**
+        * \return The next queued URL, an empty one if there is none and the worker is done.
+        * \p last is set if it was the last worker running then.
+        */
+        QUrl next(bool* last);
+
+        /// Opens \p url on \p core and collects what the demuxer reports.
+        QVariantMap scan(mpv_handle* core, const QUrl& url, quint64 generation);
+
+        /// \return An idle scanning core, a newly created one if none is idle.
+        mpv_handle* takeCore();
+        static mpv_handle* createCore();
+
+        /// Guards m_queue, m_active, m_idle and m_running
+        mutable QMutex m_lock;
+        QQueue<QUrl> m_queue;
+        /// URLs taken by workers and not reported yet
+        int m_active;
+        QList<mpv_handle*> m_idle;
+        int m_running;
+        const int m_capacity;
+        std::atomic<quint64> m_generation;
+        QThreadPool m_workers;
+    };
+
+} // namespace Phonon::MPV
+
+#endif // PHONON_MPV_MEDIASCANNER_H
@@ -0,0 +1,285 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mimetypes.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include <QSet>
+
+#define MPV_ENABLE_DEPRECATED 0
+#include <mpv/client.h>
+
+#include <cstring>
+#include <iterator>
+
+#include "utils/debug.h"
+
+namespace {
+
+// Identifies the cache file format, bump on changes.
+const quint32 CACHE_MAGIC = 0x70686d74; // "phmt"
+const quint32 CACHE_VERSION = 2;
+
+struct MimeCapability {
+    const char* mimeType;
+    /// libavformat demuxer, nullptr for types mpv handles itself (playlists, discs)
+    const char* demuxer;
+    /// codec the type implies, nullptr if the container is enough
+    const char* codec;
+};
+
+constexpr MimeCapability CAPABILITIES[]{
+    {"application/mpeg4-iod", "mov", nullptr},
+    {"application/mpeg4-muxcodetable", "mov", nullptr},
+    {"application/mxf", "mxf", nullptr},
+    {"application/ogg", "ogg", nullptr},
+    {"application/ram", nullptr, nullptr},
+    {"application/sdp", "sdp", nullptr},
+    {"application/vnd.apple.mpegurl", "hls", nullptr},
+    {"application/vnd.ms-asf", "asf", nullptr},
+    {"application/vnd.ms-wpl", nullptr, nullptr},
+    {"application/vnd.rn-realmedia", "rm", nullptr},
+    {"application/vnd.rn-realmedia-vbr", "rm", nullptr},
+    {"application/x-cd-image", nullptr, nullptr},
+    {"application/x-extension-m4a", "mov", "aac"},
+    {"application/x-extension-mp4", "mov", nullptr},
+    {"application/x-flac", "flac", "flac"},
+    {"application/x-flash-video", "flv", nullptr},
+    {"application/x-matroska", "matroska", nullptr},
+    {"application/x-ogg", "ogg", nullptr},
+    {"application/x-quicktime-media-link", nullptr, nullptr},
+    {"application/x-quicktimeplayer", "mov", nullptr},
+    {"application/x-shockwave-flash", "swf", nullptr},
+    {"application/xspf+xml", nullptr, nullptr},
+    {"audio/3gpp", "mov", nullptr},
+    {"audio/3gpp2", "mov", nullptr},
+    {"audio/AMR", "amr", "amrnb"},
+    {"audio/AMR-WB", "amr", "amrwb"},
+    {"audio/aac", "aac", "aac"},
+    {"audio/ac3", "ac3", "ac3"},
+    {"audio/basic", "au", nullptr},
+    {"audio/dv", "dv", nullptr},
+    {"audio/eac3", "eac3", "eac3"},
+    {"audio/flac", "flac", "flac"},
+    {"audio/m4a", "mov", "aac"},
+    // audio/midi of the former list is left out, neither libavformat nor mpv synthesize MIDI.
+    {"audio/mp1", "mp3", "mp1"},
+    {"audio/mp2", "mp3", "mp2"},
+    {"audio/mp3", "mp3", "mp3"},
+    {"audio/mp4", "mov", "aac"},
+    {"audio/mpeg", "mp3", "mp3"},
+    {"audio/mpegurl", nullptr, nullptr},
+    {"audio/mpg", "mp3", "mp3"},
+    {"audio/ogg", "ogg", "vorbis"},
+    {"audio/opus", "ogg", "opus"},
+    {"audio/scpls", nullptr, nullptr},
+    {"audio/vnd.dolby.heaac.1", "aac", "aac"},
+    {"audio/vnd.dolby.heaac.2", "aac", "aac"},
+    {"audio/vnd.dolby.mlp", "mlp", "mlp"},
+    {"audio/vnd.dts", "dts", "dts"},
+    {"audio/vnd.dts.hd", "dtshd", "dts"},
+    {"audio/vnd.rn-realaudio", "rm", nullptr},
+    {"audio/vorbis", "ogg", "vorbis"},
+    {"audio/wav", "wav", nullptr},
+    {"audio/webm", "matroska", nullptr},
+    {"audio/x-aac", "aac", "aac"},
+    {"audio/x-adpcm", "wav", nullptr},
+    {"audio/x-aiff", "aiff", nullptr},
+    {"audio/x-ape", "ape", "ape"},
+    {"audio/x-flac", "flac", "flac"},
+    {"audio/x-gsm", "gsm", "gsm"},
+    {"audio/x-it", "libopenmpt", nullptr},
+    {"audio/x-m4a", "mov", "aac"},
+    {"audio/x-matroska", "matroska", nullptr},
+    {"audio/x-mod", "libopenmpt", nullptr},
+    {"audio/x-mp1", "mp3", "mp1"},
+    {"audio/x-mp2", "mp3", "mp2"},
+    {"audio/x-mp3", "mp3", "mp3"},
+    {"audio/x-mpeg", "mp3", "mp3"},
+    {"audio/x-mpegurl", nullptr, nullptr},
+    {"audio/x-mpg", "mp3", "mp3"},
+    {"audio/x-ms-asf", "asf", nullptr},
+    {"audio/x-ms-asx", nullptr, nullptr},
+    {"audio/x-ms-wax", nullptr, nullptr},
+    {"audio/x-ms-wma", "asf", "wmav2"},
+    {"audio/x-musepack", "mpc", nullptr},
+    {"audio/x-pn-aiff", "aiff", nullptr},
+    {"audio/x-pn-au", "au", nullptr},
+    {"audio/x-pn-realaudio", "rm", nullptr},
+    {"audio/x-pn-realaudio-plugin", "rm", nullptr},
+    {"audio/x-pn-wav", "wav", nullptr},
+    {"audio/x-pn-windows-acm", "wav", nullptr},
+    {"audio/x-real-audio", "rm", nullptr},
+    {"audio/x-realaudio", "rm", nullptr},
+    {"audio/x-s3m", "libopenmpt", nullptr},
+    {"audio/x-scpls", nullptr, nullptr},
+    {"audio/x-shorten", "shn", "shorten"},
+    {"audio/x-speex", "ogg", "speex"},
+    {"audio/x-tta", "tta", "tta"},
+    {"audio/x-vorbis", "ogg", "vorbis"},
+    {"audio/x-vorbis+ogg", "ogg", "vorbis"},
+    {"audio/x-wav", "wav", nullptr},
+    {"audio/x-wavpack", "wv", "wavpack"},
+    {"audio/x-xm", "libopenmpt", nullptr},
+    {"image/vnd.rn-realpix", "rm", nullptr},
+    {"misc/ultravox", nullptr, nullptr},
+    {"text/google-video-pointer", nullptr, nullptr},
+    {"text/x-google-video-pointer", nullptr, nullptr},
+    {"video/3gp", "mov", nullptr},
+    {"video/3gpp", "mov", nullptr},
+    {"video/3gpp2", "mov", nullptr},
+    {"video/avi", "avi", nullptr},
+    {"video/divx", "avi", "mpeg4"},
+    {"video/dv", "dv", "dvvideo"},
+    {"video/fli", "flic", "flic"},
+    {"video/flv", "flv", nullptr},
+    {"video/mp2t", "mpegts", nullptr},
+    {"video/mp4", "mov", nullptr},
+    {"video/mp4v-es", "m4v", "mpeg4"},
+    {"video/mpeg", "mpeg", nullptr},
+    {"video/mpeg-system", "mpeg", nullptr},
+    {"video/msvideo", "avi", nullptr},
+    {"video/ogg", "ogg", nullptr},
+    {"video/quicktime", "mov", nullptr},
+    {"video/vnd.divx", "avi", "mpeg4"},
+    {"video/vnd.mpegurl", nullptr, nullptr},
+    {"video/vnd.rn-realvideo", "rm", nullptr},
+    {"video/webm", "matroska", nullptr},
+    {"video/x-anim", "iff", "iff_ilbm"},
+    {"video/x-avi", "avi", nullptr},
+    {"video/x-flc", "flic", "flic"},
+    {"video/x-fli", "flic", "flic"},
+    {"video/x-flv", "flv", nullptr},
+    {"video/x-m4v", "mov", nullptr},
+    {"video/x-matroska", "matroska", nullptr},
+    {"video/x-mpeg", "mpeg", nullptr},
+    {"video/x-mpeg-system", "mpeg", nullptr},
+    {"video/x-mpeg2", "mpeg", "mpeg2video"},
+    {"video/x-ms-asf", "asf", nullptr},
+    {"video/x-ms-asf-plugin", "asf", nullptr},
+    {"video/x-ms-asx", nullptr, nullptr},
+    {"video/x-ms-wm", "asf", nullptr},
+    {"video/x-ms-wmv", "asf", nullptr},
+    {"video/x-ms-wmx", nullptr, nullptr},
+    {"video/x-ms-wvx", nullptr, nullptr},
+    {"video/x-msvideo", "avi", nullptr},
+    {"video/x-nsv", "nsv", nullptr},
+    {"video/x-ogm", "ogg", nullptr},
+    {"video/x-ogm+ogg", "ogg", nullptr},
+    {"video/x-theora", "ogg", "theora"},
+    {"video/x-theora+ogg", "ogg", "theora"},
+    {"x-content/audio-cdda", nullptr, nullptr},
+    {"x-content/audio-player", nullptr, nullptr},
+    {"x-content/video-dvd", nullptr, nullptr},
+    {"x-content/video-svcd", nullptr, nullptr},
+    {"x-content/video-vcd", nullptr, nullptr},
+};
+
+// Collects the string values of a node array, or of the key \p field of each map in it.
+QSet<QByteArray> collect(mpv_handle* core, const char* property, const char* field) {
+    QSet<QByteArray> names;
+    mpv_node list;
+    auto err{0};
+    if((err = mpv_get_property(core, property, MPV_FORMAT_NODE, &list))) {
+        warning() << "Failed to get" << property << ":" << mpv_error_string(err);
+        return names;
+    }
+    if(list.format == MPV_FORMAT_NODE_ARRAY) {
+        for(auto i{0}; i < list.u.list->num; i++) {
+            const auto& value{list.u.list->values[i]};
+            const char* name{nullptr};
+            if(!field && value.format == MPV_FORMAT_STRING) {
+                name = value.u.string;
+            } else if(field && value.format == MPV_FORMAT_NODE_MAP) {
+                for(auto j{0}; j < value.u.list->num; j++) {
+                    if(!strcmp(value.u.list->keys[j], field) && value.u.list->values[j].format == MPV_FORMAT_STRING)
+                        name = value.u.list->values[j].u.string;
+                }
+            }
+            // libavformat names aliases with commas, e.g. "mov,mp4,m4a,3gp,3g2,mj2".
+            if(name) {
+                for(const auto& alias : QByteArray(name).split(','))
+                    names.insert(alias);
+            }
+        }
+    }
+    mpv_free_node_contents(&list);
+    return names;
+}
+
+} // namespace
+
+QStringList Phonon::MPV::probeMimeTypes(mpv_handle* core) {
+    const auto demuxers{collect(core, "demuxer-lavf-list", nullptr)};
+    const auto codecs{collect(core, "decoder-list", "codec")};
+    QStringList types;
+    if(demuxers.isEmpty() || codecs.isEmpty())
+        return types;
+    for(const auto& capability : CAPABILITIES) {
+        if(capability.demuxer && !demuxers.contains(capability.demuxer))
+            continue;
+        if(capability.codec && !codecs.contains(capability.codec))
+            continue;
+        types.append(QLatin1String(capability.mimeType));
+    }
+    debug() << "mpv supports" << types.size() << "of" << std::size(CAPABILITIES) << "known MIME types";
+    return types;
+}
+
+QStringList Phonon::MPV::knownMimeTypes() {
+    QStringList types;
+    for(const auto& capability : CAPABILITIES)
+        types.append(QLatin1String(capability.mimeType));
+    return types;
+}
+
+QByteArray Phonon::MPV::buildIdentifier(mpv_handle* core) {
+    QByteArray build;
+    for(const auto property : {"mpv-version", "ffmpeg-version"}) {
+        if(char* version{mpv_get_property_string(core, property)}) {
+            if(!build.isEmpty())
+                build += " / ";
+            build += version;
+            mpv_free(version);
+        }
+    }
+    return build;
+}
+
+bool Phonon::MPV::MimeTypeCache::load(const QString& path) {
+    QFile file{path};
+    if(path.isEmpty() || !file.open(QIODevice::ReadOnly))
+        return false;
+    QDataStream stream{&file};
+    quint32 magic{0}, version{0};
+    stream >> magic >> version;
+    if(magic != CACHE_MAGIC || version != CACHE_VERSION)
+        return false;
+    stream >> apiVersion >> build >> types;
+    return stream.status() == QDataStream::Ok && !types.isEmpty();
+}
+
+bool Phonon::MPV::MimeTypeCache::save(const QString& path) const {
+    QSaveFile file{path};
+    if(path.isEmpty() || !file.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream stream{&file};
+    stream << CACHE_MAGIC << CACHE_VERSION << apiVersion << build << types;
+    return file.commit();
+}
@@ -0,0 +1,56 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_MPV_MIMETYPES_H
+#define PHONON_MPV_MIMETYPES_H
+
+#include <QByteArray>
+#include <QStringList>
+
+struct mpv_handle;
+
+namespace Phonon::MPV {
+
+    /**
+    * \return The MIME types the demuxers and decoders of \p core can play, derived from
+    * demuxer-lavf-list and decoder-list.
+    */
+    QStringList probeMimeTypes(mpv_handle* core);
+
+    /// \return Every MIME type that maps to mpv, regardless of the build.
+    QStringList knownMimeTypes();
+
+    /// \return Identifies the mpv and FFmpeg build of \p core, e.g. "mpv 0.38.0 / 6.1.1".
+    QByteArray buildIdentifier(mpv_handle* core);
+
+    /** \brief Probed MIME types stored on disk
+    *
+    * Keyed by the client API version, which is known before a core exists, and the build
+    * identifier, which is checked once a core is up anyway.
+    */
+    struct MimeTypeCache {
+        quint64 apiVersion{0};
+        QByteArray build;
+        QStringList types;
+
+        bool load(const QString& path);
+        bool save(const QString& path) const;
+    };
+
+} // namespace Phonon::MPV
+
+#endif // PHONON_MPV_MIMETYPES_H
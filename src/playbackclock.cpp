@@ -0,0 +1,106 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "playbackclock.h"
+
+#include <chrono>
+
+using namespace Phonon::MPV;
+
+// Never extrapolate further than this past the last update (nanoseconds), in case
+// position updates stall without a state change (e.g. a starving decoder).
+static const qint64 MAX_EXTRAPOLATION = 1000 * 1000 * 1000;
+
+PlaybackClock::PlaybackClock()
+    : m_sequence(0)
+    , m_position(0.0)
+    , m_anchor(now())
+    , m_speed(1.0)
+    , m_running(false) {
+}
+
+qint64 PlaybackClock::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+PlaybackClock::Snapshot PlaybackClock::load() const {
+    Snapshot snapshot;
+    quint32 before;
+    do {
+        while((before = m_sequence.load(std::memory_order_acquire)) & 1);
+        snapshot.position = m_position.load(std::memory_order_relaxed);
+        snapshot.anchor = m_anchor.load(std::memory_order_relaxed);
+        snapshot.speed = m_speed.load(std::memory_order_relaxed);
+        snapshot.running = m_running.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while(before != m_sequence.load(std::memory_order_relaxed));
+    return snapshot;
+}
+
+void PlaybackClock::store(const Snapshot& snapshot) {
+    const auto sequence{m_sequence.load(std::memory_order_relaxed)};
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_position.store(snapshot.position, std::memory_order_relaxed);
+    m_anchor.store(snapshot.anchor, std::memory_order_relaxed);
+    m_speed.store(snapshot.speed, std::memory_order_relaxed);
+    m_running.store(snapshot.running, std::memory_order_relaxed);
+    m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void PlaybackClock::update(double position) {
+    auto snapshot{load()};
+    snapshot.position = position;
+    snapshot.anchor = now();
+    store(snapshot);
+}
+
+void PlaybackClock::setRunning(bool running) {
+    auto snapshot{load()};
+    if(snapshot.running == running)
+        return;
+    // Re-anchor so the time accumulated so far is kept (or not extrapolated further).
+    snapshot.position = time() / 1000.0;
+    snapshot.anchor = now();
+    snapshot.running = running;
+    store(snapshot);
+}
+
+void PlaybackClock::setSpeed(double speed) {
+    auto snapshot{load()};
+    snapshot.position = time() / 1000.0;
+    snapshot.anchor = now();
+    snapshot.speed = speed;
+    store(snapshot);
+}
+
+void PlaybackClock::reset(double position) {
+    store(Snapshot{position, now(), load().speed, false});
+}
+
+qint64 PlaybackClock::time() const {
+    const auto snapshot{load()};
+    auto position{snapshot.position};
+    if(snapshot.running) {
+        auto elapsed{now() - snapshot.anchor};
+        if(elapsed > MAX_EXTRAPOLATION)
+            elapsed = MAX_EXTRAPOLATION;
+        position += elapsed / 1e9 * snapshot.speed;
+    }
+    return static_cast<qint64>(position * 1000);
+}
@@ -0,0 +1,74 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_MPV_PLAYBACKCLOCK_H
+#define PHONON_MPV_PLAYBACKCLOCK_H
+
+#include <QtGlobal>
+
+#include <atomic>
+
+namespace Phonon::MPV {
+
+    /** \brief Interpolated media clock
+    *
+    * The clock is anchored on every observed position update and extrapolated with a
+    * monotonic clock, the playback speed and whether playback is running. It is written
+    * from one thread only and can be read lock-free (seqlock) from any thread without
+    * calling into libmpv.
+    */
+    class PlaybackClock {
+    public:
+        PlaybackClock();
+
+        /// Anchors the clock at \p position (seconds).
+        void update(double position);
+
+        /// Sets whether the media time advances, e.g. false while paused or buffering.
+        void setRunning(bool running);
+
+        void setSpeed(double speed);
+
+        /// Anchors the clock at \p position (seconds) and stops it.
+        void reset(double position = 0.0);
+
+        /// \return The interpolated media time in milliseconds.
+        qint64 time() const;
+
+    private:
+        static qint64 now();
+
+        struct Snapshot {
+            double position;
+            qint64 anchor;
+            double speed;
+            bool running;
+        };
+
+        Snapshot load() const;
+        void store(const Snapshot& snapshot);
+
+        std::atomic<quint32> m_sequence;
+        std::atomic<double> m_position;
+        std::atomic<qint64> m_anchor;
+        std::atomic<double> m_speed;
+        std::atomic<bool> m_running;
+    };
+
+} // namespace Phonon::MPV
+
+#endif // PHONON_MPV_PLAYBACKCLOCK_H
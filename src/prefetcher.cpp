@@ -0,0 +1,125 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "prefetcher.h"
+
+#include <QFile>
+#include <QThread>
+#include <QUrl>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "utils/debug.h"
+
+// Bytes warmed at the start of a file, the header and the first seconds of most formats
+static const qint64 HEAD_BYTES = 4 * 1024 * 1024;
+// Bytes warmed at the end of a file, MP4 indexes and ID3v1/APE tags
+static const qint64 TAIL_BYTES = 256 * 1024;
+// Bytes warmed for all sources of one prefetch()
+static const qint64 BUDGET_BYTES = 16 * 1024 * 1024;
+// Reads between checks for cancellation
+static const qint64 CHUNK_BYTES = 256 * 1024;
+
+#ifdef __linux__
+// From linux/ioprio.h, which older kernel headers do not install
+static const int IOPRIO_CLASS_IDLE = 3;
+static const int IOPRIO_CLASS_SHIFT = 13;
+static const int IOPRIO_WHO_PROCESS = 1;
+#endif
+
+using namespace Phonon::MPV;
+
+Prefetcher::Prefetcher()
+    : m_enabled(qgetenv("PHONON_MPV_PREFETCH") != "0")
+    , m_generation(0) {
+    m_worker.setMaxThreadCount(1);
+}
+
+Prefetcher::~Prefetcher() {
+    cancel();
+    m_worker.waitForDone();
+}
+
+void Prefetcher::prefetch(const QList<QByteArray>& mrls) {
+    const auto generation{++m_generation};
+    m_worker.clear();
+    if(!m_enabled || mrls.isEmpty())
+        return;
+    m_worker.start([this, mrls, generation] { run(mrls, generation); });
+}
+
+void Prefetcher::cancel() {
+    ++m_generation;
+    m_worker.clear();
+}
+
+void Prefetcher::run(const QList<QByteArray>& mrls, quint64 generation) {
+    // Playback must not wait on the disk behind the prefetcher. The thread priority only
+    // affects the CPU, the idle I/O class also keeps the reads behind the ones of mpv.
+    QThread::currentThread()->setPriority(QThread::IdlePriority);
+#ifdef __linux__
+    // Applies to the calling thread only, the worker keeps it for its lifetime.
+    if(syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) < 0)
+        debug() << "Failed to lower the I/O priority of the prefetcher:" << strerror(errno);
+#endif
+    auto budget{BUDGET_BYTES};
+    for(const auto& mrl : mrls) {
+        if(budget <= 0 || generation != m_generation)
+            break;
+        const auto url{QUrl::fromEncoded(mrl)};
+        if(!url.isLocalFile())
+            continue;
+
+        // Resolving the path and its attributes already helps on network mounts.
+        const auto fd{::open(QFile::encodeName(url.toLocalFile()).constData(), O_RDONLY | O_CLOEXEC)};
+        if(fd < 0)
+            continue;
+        struct stat info;
+        if(fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+            const auto size{static_cast<qint64>(info.st_size)};
+            const auto head{qMin(size, qMin(HEAD_BYTES, budget))};
+            const auto tail{qMin(size - head, qMin(TAIL_BYTES, budget - head))};
+            if(warm(fd, 0, head, generation) && tail > 0)
+                warm(fd, size - tail, tail, generation);
+            budget -= head + qMax<qint64>(0, tail);
+            debug() << "prefetched" << head << "+" << qMax<qint64>(0, tail) << "bytes of" << mrl;
+        }
+        ::close(fd);
+    }
+}
+
+bool Prefetcher::warm(int fd, qint64 offset, qint64 length, quint64 generation) {
+    for(auto done{qint64(0)}; done < length; done += CHUNK_BYTES) {
+        if(generation != m_generation)
+            return false;
+        const auto chunk{qMin(CHUNK_BYTES, length - done)};
+#ifdef __linux__
+        // Blocks until the chunk is cached, which keeps the reads paced and cancellable.
+        ::readahead(fd, offset + done, static_cast<size_t>(chunk));
+#else
+        posix_fadvise(fd, offset + done, chunk, POSIX_FADV_WILLNEED);
+#endif
+    }
+    return true;
+}
@@ -0,0 +1,71 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_MPV_PREFETCHER_H
+#define PHONON_MPV_PREFETCHER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QThreadPool>
+
+#include <atomic>
+
+namespace Phonon::MPV {
+
+    /** \brief Warms the page cache for sources that play next
+    *
+    * The first read of a source stalls on spinning disks and network mounts. While the current
+    * source plays, the prefetcher reads the head, where containers keep their header and the
+    * first seconds, and the tail, where MP4 may keep its index and tags live, of upcoming local
+    * files into the page cache. It runs on a thread with idle CPU and, on Linux, idle I/O
+    * priority within a byte budget.
+    *
+    * Every prefetch() or cancel() starts a new generation, running work of an older one stops
+    * at its next chunk.
+    */
+    class Prefetcher {
+    public:
+        Prefetcher();
+        ~Prefetcher();
+
+        /**
+        * Replaces the work by warming \p mrls, in this order. MRLs that are no local files are
+        * skipped. Disabled by PHONON_MPV_PREFETCH=0.
+        */
+        void prefetch(const QList<QByteArray>& mrls);
+
+        /// Drops queued and stops running work.
+        void cancel();
+
+    private:
+        /// Runs on m_worker, warms \p mrls as long as \p generation is current.
+        void run(const QList<QByteArray>& mrls, quint64 generation);
+
+        /**
+        * Reads \p length bytes at \p offset of \p fd into the page cache.
+        * \return \c false if \p generation was superseded meanwhile.
+        */
+        bool warm(int fd, qint64 offset, qint64 length, quint64 generation);
+
+        const bool m_enabled;
+        std::atomic<quint64> m_generation;
+        QThreadPool m_worker;
+    };
+
+} // namespace Phonon::MPV
+
+#endif // PHONON_MPV_PREFETCHER_H
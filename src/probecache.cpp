@@ -0,0 +1,176 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "probecache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QUrl>
+
+#include "utils/debug.h"
+
+// Identifies the cache file format, bump on changes.
+static const quint32 CACHE_MAGIC = 0x70687063; // "phpc"
+static const quint32 CACHE_VERSION = 2;
+// Entries kept at most, the least recently used ones are evicted
+static const int MAX_ENTRIES = 4096;
+
+using namespace Phonon::MPV;
+
+ProbeCache::ProbeCache()
+    : m_dirty(false) {
+}
+
+bool ProbeCache::identify(const QByteArray& mrl, QByteArray* key, qint64* size, qint64* modified) {
+    const auto url{QUrl::fromEncoded(mrl)};
+    const auto scheme{url.scheme().toLower()};
+    *size = -1;
+    *modified = -1;
+    if(scheme == QLatin1String("file")) {
+        const QFileInfo info{url.toLocalFile()};
+        if(!info.isFile())
+            return false;
+        *size = info.size();
+        *modified = info.lastModified().toMSecsSinceEpoch();
+    } else if(scheme != QLatin1String("http") && scheme != QLatin1String("https")
+              && scheme != QLatin1String("ftp")) {
+        return false;
+    }
+    *key = QCryptographicHash::hash(mrl, QCryptographicHash::Sha1);
+    return true;
+}
+
+QList<QPair<QByteArray, QByteArray>> ProbeCache::hints(const QByteArray& mrl) {
+    QList<QPair<QByteArray, QByteArray>> options;
+    QByteArray key;
+    qint64 size, modified;
+    if(!identify(mrl, &key, &size, &modified))
+        return options;
+    auto it{m_entries.find(key)};
+    if(it == m_entries.end())
+        return options;
+    if(it->size != size || it->modified != modified) {
+        // The file changed since it was probed.
+        m_entries.erase(it);
+        m_dirty = true;
+        return options;
+    }
+    it->used = QDateTime::currentSecsSinceEpoch();
+    m_dirty = true;
+
+    if(it->demuxer == "lavf") {
+        // libavformat names aliases with commas, e.g. "mov,mp4,m4a,3gp,3g2,mj2".
+        options.append({"demuxer", "lavf"});
+        options.append({"demuxer-lavf-format", it->format.split(',').first()});
+        // The format is known, only the streams are left to find.
+        options.append({"demuxer-lavf-probesize", "1048576"});
+        options.append({"demuxer-lavf-analyzeduration", "2"});
+    } else {
+        options.append({"demuxer", it->demuxer});
+    }
+    return options;
+}
+
+void ProbeCache::record(const QByteArray& mrl, const QByteArray& demuxer, const QByteArray& format) {
+    // Only the demuxers hints() knows how to force, e.g. not playlists or archives.
+    if(demuxer != "lavf" && demuxer != "mkv")
+        return;
+    if(demuxer == "lavf" && format.isEmpty())
+        return;
+    Entry entry{-1, -1, demuxer, format, QDateTime::currentSecsSinceEpoch()};
+    QByteArray key;
+    if(!identify(mrl, &key, &entry.size, &entry.modified))
+        return;
+
+    if(!m_entries.contains(key) && m_entries.size() >= MAX_ENTRIES) {
+        auto oldest{m_entries.begin()};
+        for(auto it{m_entries.begin()}; it != m_entries.end(); ++it) {
+            if(it->used < oldest->used)
+                oldest = it;
+        }
+        m_entries.erase(oldest);
+    }
+    debug() << "probed" << mrl << "as" << demuxer << format;
+    m_entries.insert(key, entry);
+    m_dirty = true;
+}
+
+void ProbeCache::forget(const QByteArray& mrl) {
+    QByteArray key;
+    qint64 size, modified;
+    if(identify(mrl, &key, &size, &modified) && m_entries.remove(key))
+        m_dirty = true;
+}
+
+bool ProbeCache::load(const QString& path) {
+    QFile file{path};
+    if(path.isEmpty() || !file.open(QIODevice::ReadOnly))
+        return false;
+    QDataStream stream{&file};
+    quint32 magic{0}, version{0};
+    QByteArray build;
+    qint32 count{0};
+    stream >> magic >> version >> build >> count;
+    if(magic != CACHE_MAGIC || version != CACHE_VERSION || count < 0)
+        return false;
+
+    QHash<QByteArray, Entry> entries;
+    for(auto i{0}; i < count; i++) {
+        QByteArray key;
+        Entry entry;
+        stream >> key >> entry.size >> entry.modified >> entry.demuxer >> entry.format >> entry.used;
+        entries.insert(key, entry);
+    }
+    if(stream.status() != QDataStream::Ok) {
+        warning() << "Ignoring damaged probe cache" << path;
+        return false;
+    }
+    m_entries = entries;
+    m_build = build;
+    m_dirty = false;
+    return true;
+}
+
+void ProbeCache::setBuild(const QByteArray& build) {
+    if(build == m_build)
+        return;
+    if(!m_entries.isEmpty())
+        debug() << "Dropping probe cache of" << m_build << ", now running" << build;
+    m_entries.clear();
+    m_build = build;
+    m_dirty = true;
+}
+
+bool ProbeCache::save(const QString& path) {
+    if(!m_dirty)
+        return true;
+    QSaveFile file{path};
+    if(path.isEmpty() || !file.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream stream{&file};
+    stream << CACHE_MAGIC << CACHE_VERSION << m_build << qint32(m_entries.size());
+    for(auto it{m_entries.cbegin()}; it != m_entries.cend(); ++it)
+        stream << it.key() << it->size << it->modified << it->demuxer << it->format << it->used;
+    if(!file.commit())
+        return false;
+    m_dirty = false;
+    return true;
+}
@@ -0,0 +1,93 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_MPV_PROBECACHE_H
+#define PHONON_MPV_PROBECACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+
+namespace Phonon::MPV {
+
+    /** \brief Demuxers detected for previously opened sources
+    *
+    * Opening a source makes libavformat probe the container from scratch, which dominates
+    * the open latency of formats like MPEG-TS or raw AAC. The cache remembers the demuxer
+    * and format mpv settled on, so a re-open is told the format instead.
+    *
+    * Local files are identified by path, size and modification time, network sources by
+    * their URL. Entries are dropped with another mpv or FFmpeg build, when the file changed
+    * or when forget() is called because a hint turned out to be wrong.
+    */
+    class ProbeCache {
+    public:
+        ProbeCache();
+
+        /**
+        * \return Per-file loadfile options forcing the demuxer recorded for \p mrl,
+        * none if nothing is known about it.
+        */
+        QList<QPair<QByteArray, QByteArray>> hints(const QByteArray& mrl);
+
+        /**
+        * Records the demuxer mpv opened \p mrl with, as reported by the current-demuxer and
+        * file-format properties.
+        */
+        void record(const QByteArray& mrl, const QByteArray& demuxer, const QByteArray& format);
+
+        /// Drops what is known about \p mrl.
+        void forget(const QByteArray& mrl);
+
+        /// Replaces the cache by the one stored in \p path. \return \c false if it is not readable.
+        bool load(const QString& path);
+
+        /**
+        * Drops the entries unless they were recorded with \p build, see buildIdentifier().
+        * Demuxer and format names come from libavformat, they can change with any rebuild.
+        */
+        void setBuild(const QByteArray& build);
+        /// Stores the cache in \p path if it changed. \return \c false if it could not be written.
+        bool save(const QString& path);
+
+    private:
+        struct Entry {
+            qint64 size;
+            qint64 modified;
+            QByteArray demuxer;
+            QByteArray format;
+            /// Seconds since epoch of the last hint or record, the oldest entries are evicted
+            qint64 used;
+        };
+
+        /**
+        * Identifies \p mrl by \p key. Local files also report their \p size and \p modified time.
+        * \return \c false for sources not worth caching, e.g. capture devices and discs.
+        */
+        static bool identify(const QByteArray& mrl, QByteArray* key, qint64* size, qint64* modified);
+
+        QHash<QByteArray, Entry> m_entries;
+        /// Build of mpv and FFmpeg the entries were recorded with
+        QByteArray m_build;
+        bool m_dirty;
+    };
+
+} // namespace Phonon::MPV
+
+#endif // PHONON_MPV_PROBECACHE_H
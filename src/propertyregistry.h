@@ -0,0 +1,176 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_MPV_PROPERTYREGISTRY_H
+#define PHONON_MPV_PROPERTYREGISTRY_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+#ifndef MPV_ENABLE_DEPRECATED
+#define MPV_ENABLE_DEPRECATED 0
+#endif
+#include <mpv/client.h>
+
+#include "eventdispatcher.h"
+#include "utils/debug.h"
+
+namespace Phonon::MPV {
+
+    /** \brief One entry of a property table
+    *
+    * Binds the name of an observed mpv property to the format it is observed with and
+    * a handler that receives the already typed value. Unless \c unavailable is set, the
+    * handler is not called while the property is unavailable.
+    *
+    * \see bindProperty()
+    */
+    template<typename Owner>
+    struct PropertyBinding {
+        const char* name;
+        mpv_format format;
+        void (*handler)(Owner*, const Event&);
+        /// Also call the handler with an empty value when the property becomes unavailable
+        bool unavailable;
+    };
+
+    /// Maps the argument type of a handler to the mpv_format it is observed with.
+    template<typename T>
+    struct PropertyFormat;
+
+    template<>
+    struct PropertyFormat<double> {
+        static constexpr mpv_format format{MPV_FORMAT_DOUBLE};
+        static double value(const Event& event) { return event.value.d; }
+    };
+
+    template<>
+    struct PropertyFormat<bool> {
+        static constexpr mpv_format format{MPV_FORMAT_FLAG};
+        static bool value(const Event& event) { return event.value.i; }
+    };
+
+    template<>
+    struct PropertyFormat<qint64> {
+        static constexpr mpv_format format{MPV_FORMAT_INT64};
+        static qint64 value(const Event& event) { return event.value.i; }
+    };
+
+    template<>
+    struct PropertyFormat<QByteArray> {
+        static constexpr mpv_format format{MPV_FORMAT_STRING};
+        static const QByteArray& value(const Event& event) { return event.text; }
+    };
+
+    /// Handlers without an argument only get notified, the value has to be fetched (MPV_FORMAT_NODE).
+    template<>
+    struct PropertyFormat<void> {
+        static constexpr mpv_format format{MPV_FORMAT_NODE};
+    };
+
+    template<typename Handler>
+    struct PropertyHandler;
+
+    template<typename Owner_, typename Arg>
+    struct PropertyHandler<void (Owner_::*)(Arg)> {
+        using Owner = Owner_;
+        using Format = PropertyFormat<std::decay_t<Arg>>;
+
+        template<auto Handler>
+        static void invoke(Owner* owner, const Event& event) { (owner->*Handler)(Format::value(event)); }
+    };
+
+    template<typename Owner_>
+    struct PropertyHandler<void (Owner_::*)()> {
+        using Owner = Owner_;
+        using Format = PropertyFormat<void>;
+
+        template<auto Handler>
+        static void invoke(Owner* owner, const Event&) { (owner->*Handler)(); }
+    };
+
+    /**
+    * Creates the table entry for the property \p name, the format is deduced from the
+    * argument of \p Handler.
+    *
+    * \code
+    * constexpr PropertyBinding<MediaObject> MediaObject::s_properties[]{
+    *     bindProperty<&MediaObject::onSeekable>("seekable"),
+    * };
+    * \endcode
+    */
+    template<auto Handler>
+    constexpr PropertyBinding<typename PropertyHandler<decltype(Handler)>::Owner> bindProperty(const char* name, bool unavailable = false) {
+        using Traits = PropertyHandler<decltype(Handler)>;
+        return {name, Traits::Format::format, &Traits::template invoke<Handler>, unavailable};
+    }
+
+    /** \brief Observes properties of a table on demand and dispatches their changes
+    *
+    * The index of a property in the table doubles as the reply_userdata it is observed
+    * with, so dispatching an event is a bounds check and an indexed call. Attaching is
+    * reference counted, a property is only observed while anyone is attached to it.
+    */
+    template<typename Owner, std::size_t Count>
+    class PropertyRegistry {
+    public:
+        using Table = PropertyBinding<Owner>[Count];
+
+        explicit PropertyRegistry(const Table& table) : m_table(table), m_references{} {}
+
+        void attach(mpv_handle* handle, std::size_t index) {
+            Q_ASSERT(index < Count);
+            if(m_references[index]++)
+                return;
+            const auto& binding{m_table[index]};
+            if(const auto err{mpv_observe_property(handle, index, binding.name, binding.format)})
+                warning() << "Failed to observe" << binding.name << ":" << mpv_error_string(err);
+        }
+
+        void detach(mpv_handle* handle, std::size_t index) {
+            Q_ASSERT(index < Count);
+            if(!m_references[index] || --m_references[index])
+                return;
+            mpv_unobserve_property(handle, index);
+        }
+
+        bool isAttached(std::size_t index) const {
+            return index < Count && m_references[index];
+        }
+
+        /// Calls the handler of a MPV_EVENT_PROPERTY_CHANGE.
+        void dispatch(Owner* owner, const Event& event) const {
+            if(event.userdata >= Count || !m_references[event.userdata])
+                return;
+            const auto& binding{m_table[event.userdata]};
+            if(event.format == MPV_FORMAT_NONE && !binding.unavailable)
+                return;
+            binding.handler(owner, event);
+        }
+
+    private:
+        const Table& m_table;
+        std::array<int, Count> m_references;
+    };
+
+} // namespace Phonon::MPV
+
+#endif // PHONON_MPV_PROPERTYREGISTRY_H
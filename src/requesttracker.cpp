@@ -0,0 +1,189 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "requesttracker.h"
+
+#include <QVector>
+
+#define MPV_ENABLE_DEPRECATED 0
+#include <mpv/client.h>
+
+#include "utils/debug.h"
+
+using namespace Phonon::MPV;
+
+RequestTracker::RequestTracker()
+    : m_handle(nullptr)
+    , m_nextId(1) {
+}
+
+void RequestTracker::setHandle(mpv_handle* handle) {
+    m_handle = handle;
+    m_requests.clear();
+    m_writes.clear();
+}
+
+quint64 RequestTracker::command(Operation operation, const QList<QByteArray>& args) {
+    QVector<mpv_node> values(args.size());
+    for(auto i{0}; i < args.size(); i++) {
+        values[i].format = MPV_FORMAT_STRING;
+        values[i].u.string = const_cast<char*>(args[i].constData());
+    }
+    mpv_node_list list{static_cast<int>(values.size()), values.data(), nullptr};
+    mpv_node node;
+    node.format = MPV_FORMAT_NODE_ARRAY;
+    node.u.list = &list;
+    return command(operation, args.value(0), &node);
+}
+
+quint64 RequestTracker::command(Operation operation, const QByteArray& name, mpv_node* node) {
+    if(!m_handle)
+        return 0;
+    const auto id{m_nextId++};
+    auto err{0};
+    if((err = mpv_command_node_async(m_handle, id, node))) {
+        error() << "Failed to queue" << name << ":" << mpv_error_string(err);
+        return 0;
+    }
+    m_requests.insert(id, Request{operation, name});
+    return id;
+}
+
+quint64 RequestTracker::loadfile(Operation operation, const QByteArray& url, const char* flags,
+                                 const QList<QPair<QByteArray, QByteArray>>& options) {
+    QByteArray optionString;
+    for(const auto& option : options) {
+        if(!optionString.isEmpty())
+            optionString += ',';
+        // %length%value quotes values containing separators, e.g. filter chains.
+        optionString += option.first + "=%" + QByteArray::number(option.second.size()) + '%' + option.second;
+    }
+
+    const char* keys[]{"name", "url", "flags", "options"};
+    const char* strings[]{"loadfile", url.constData(), flags, optionString.constData()};
+    mpv_node values[4];
+    for(auto i{0}; i < 4; i++) {
+        values[i].format = MPV_FORMAT_STRING;
+        values[i].u.string = const_cast<char*>(strings[i]);
+    }
+    mpv_node_list list{optionString.isEmpty() ? 3 : 4, values, const_cast<char**>(keys)};
+    mpv_node node;
+    node.format = MPV_FORMAT_NODE_MAP;
+    node.u.list = &list;
+    return command(operation, "loadfile", &node);
+}
+
+quint64 RequestTracker::setProperty(const char* name, bool value) {
+    Write write;
+    write.format = MPV_FORMAT_FLAG;
+    write.value.i = value;
+    return setProperty(QByteArray(name), write);
+}
+
+quint64 RequestTracker::setProperty(const char* name, qint64 value) {
+    Write write;
+    write.format = MPV_FORMAT_INT64;
+    write.value.i = value;
+    return setProperty(QByteArray(name), write);
+}
+
+quint64 RequestTracker::setProperty(const char* name, double value) {
+    Write write;
+    write.format = MPV_FORMAT_DOUBLE;
+    write.value.d = value;
+    return setProperty(QByteArray(name), write);
+}
+
+quint64 RequestTracker::setProperty(const char* name, const QByteArray& value) {
+    Write write;
+    write.format = MPV_FORMAT_STRING;
+    write.string = value;
+    return setProperty(QByteArray(name), write);
+}
+
+quint64 RequestTracker::setProperty(const QByteArray& name, const Write& write) {
+    auto& slot{m_writes[name]};
+    if(slot.inFlight) {
+        // Superseded before the previous write completed, only keep the latest value.
+        slot.pending = true;
+        slot.value = write;
+        return slot.inFlight;
+    }
+    const auto id{send(name, write)};
+    if(id)
+        slot.inFlight = id;
+    else
+        m_writes.remove(name);
+    return id;
+}
+
+quint64 RequestTracker::send(const QByteArray& name, const Write& write) {
+    if(!m_handle)
+        return 0;
+    auto flag{static_cast<int>(write.value.i)};
+    auto value{write.value};
+    auto string{const_cast<char*>(write.string.constData())};
+    void* data{nullptr};
+    switch(write.format) {
+        case MPV_FORMAT_FLAG:
+            data = &flag;
+            break;
+        case MPV_FORMAT_INT64:
+            data = &value.i;
+            break;
+        case MPV_FORMAT_DOUBLE:
+            data = &value.d;
+            break;
+        case MPV_FORMAT_STRING:
+            data = &string;
+            break;
+    }
+    const auto id{m_nextId++};
+    auto err{0};
+    if((err = mpv_set_property_async(m_handle, id, name.constData(), static_cast<mpv_format>(write.format), data))) {
+        error() << "Failed to queue write of" << name << ":" << mpv_error_string(err);
+        return 0;
+    }
+    m_requests.insert(id, Request{PropertyOperation, name});
+    return id;
+}
+
+bool RequestTracker::finish(quint64 id, Request* request) {
+    const auto it{m_requests.find(id)};
+    if(it == m_requests.end())
+        return false;
+    *request = it.value();
+    m_requests.erase(it);
+
+    if(request->operation == PropertyOperation) {
+        const auto slot{m_writes.find(request->name)};
+        if(slot != m_writes.end() && slot->inFlight == id) {
+            if(slot->pending) {
+                slot->pending = false;
+                if(!(slot->inFlight = send(request->name, slot->value)))
+                    m_writes.erase(slot);
+            } else {
+                m_writes.erase(slot);
+            }
+        }
+    }
+    return true;
+}
+
+bool RequestTracker::isWriting(const QByteArray& name) const {
+    return m_writes.contains(name);
+}
@@ -0,0 +1,118 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_MPV_REQUESTTRACKER_H
+#define PHONON_MPV_REQUESTTRACKER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QPair>
+
+struct mpv_handle;
+struct mpv_node;
+
+namespace Phonon::MPV {
+
+    /** \brief Issues asynchronous commands and property writes and remembers what they were for
+    *
+    * Every request gets an id that is passed as reply_userdata, the reply events are routed
+    * back through finish() so errors can be attributed to the operation that caused them.
+    * Property writes are coalesced: while a write of a property is in flight, further writes
+    * only replace the pending value, which is sent once the previous write completed.
+    */
+    class RequestTracker {
+    public:
+        enum Operation {
+            LoadOperation,
+            QueueOperation,
+            StopOperation,
+            SeekOperation,
+            PropertyOperation,
+            CommandOperation
+        };
+
+        struct Request {
+            Operation operation;
+            /// Name of the command or property
+            QByteArray name;
+        };
+
+        RequestTracker();
+
+        void setHandle(mpv_handle* handle);
+
+        /**
+        * Runs the command \p args (name first) asynchronously.
+        * \return The request id, 0 if the command could not be queued.
+        */
+        quint64 command(Operation operation, const QList<QByteArray>& args);
+
+        /// Runs a command given as MPV_FORMAT_NODE_ARRAY or MPV_FORMAT_NODE_MAP asynchronously.
+        quint64 command(Operation operation, const QByteArray& name, mpv_node* node);
+
+        /**
+        * Runs loadfile for \p url with \p flags (replace, append, ...) and the per-file
+        * \p options (name, value) asynchronously. Named arguments are used, so this works
+        * regardless of the positional arguments of the mpv version.
+        */
+        quint64 loadfile(Operation operation, const QByteArray& url, const char* flags,
+                         const QList<QPair<QByteArray, QByteArray>>& options = {});
+
+        quint64 setProperty(const char* name, bool value);
+        quint64 setProperty(const char* name, qint64 value);
+        quint64 setProperty(const char* name, double value);
+        quint64 setProperty(const char* name, const QByteArray& value);
+
+        /**
+        * Completes the request \p id of a reply event and sends pending writes of the
+        * same property.
+        * \return \c false if the id is unknown.
+        */
+        bool finish(quint64 id, Request* request);
+
+        /// \return \c true while a write of the property \p name is in flight or pending.
+        bool isWriting(const QByteArray& name) const;
+
+    private:
+        struct Write {
+            int format{0};
+            union {
+                double d;
+                qint64 i;
+            } value{};
+            QByteArray string;
+        };
+
+        struct PropertyWrite {
+            quint64 inFlight{0};
+            bool pending{false};
+            Write value;
+        };
+
+        quint64 setProperty(const QByteArray& name, const Write& write);
+        quint64 send(const QByteArray& name, const Write& write);
+
+        mpv_handle* m_handle;
+        quint64 m_nextId;
+        QHash<quint64, Request> m_requests;
+        QHash<QByteArray, PropertyWrite> m_writes;
+    };
+
+} // namespace Phonon::MPV
+
+#endif // PHONON_MPV_REQUESTTRACKER_H
@@ -0,0 +1,442 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "thumbnailservice.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QThread>
+#include <QUrl>
+
+#define MPV_ENABLE_DEPRECATED 0
+#include <mpv/client.h>
+#include <mpv/render.h>
+
+#include <cmath>
+#include <cstring>
+
+#include "corepool.h"
+#include "utils/cache.h"
+#include "utils/debug.h"
+#include "utils/events.h"
+
+// Size of one thumbnail, mpv letterboxes other aspect ratios
+static const int TILE_WIDTH = 160;
+static const int TILE_HEIGHT = 90;
+// Thumbnails per sprite sheet row and column
+static const int SHEET_COLUMNS = 8;
+static const int SHEET_ROWS = 8;
+static const int TILES_PER_SHEET = SHEET_COLUMNS * SHEET_ROWS;
+// Thumbnails aimed at per source, the interval between them stays within the bounds below
+static const qint64 TARGET_THUMBNAILS = 100;
+static const qint64 MIN_INTERVAL = 2000;
+static const qint64 MAX_INTERVAL = 60000;
+// Bytes of sprite sheets kept in memory unless byteBudget says otherwise
+static const int DEFAULT_BYTE_BUDGET = 16 * 1024 * 1024;
+// Slots on either side of a requested one rendered along with it
+static const int NEIGHBOURS = 2;
+// Milliseconds the shadow core may take to open the source and to show a seeked frame
+static const qint64 OPEN_TIMEOUT = 10000;
+static const qint64 FRAME_TIMEOUT = 2000;
+
+using namespace Phonon::MPV;
+
+ThumbnailService::ThumbnailService(QObject* parent)
+    : QObject(parent)
+    , m_thread(nullptr)
+    , m_core(nullptr)
+    , m_render(nullptr)
+    , m_generation(0)
+    , m_stopping(false)
+    , m_interval(0)
+    , m_slots(0)
+    , m_cursor(-1)
+    , m_sheets(DEFAULT_BYTE_BUDGET)
+    , m_diskCache(false) {
+}
+
+ThumbnailService::~ThumbnailService() {
+    {
+        QMutexLocker locker(&m_lock);
+        m_stopping = true;
+        ++m_generation;
+        m_wake.wakeAll();
+    }
+    if(m_thread) {
+        m_thread->wait();
+        delete m_thread;
+    }
+}
+
+void ThumbnailService::setSource(const QByteArray& mrl) {
+    QByteArray identity;
+    const auto url{QUrl::fromEncoded(mrl)};
+    const QFileInfo info{url.toLocalFile()};
+    if(url.isLocalFile() && info.isFile()) {
+        // Sheets of a changed file must not be taken for the new content.
+        const auto key{QFile::encodeName(info.absoluteFilePath()) + '\n' + QByteArray::number(info.size()) + '\n'
+                       + QByteArray::number(info.lastModified().toMSecsSinceEpoch())};
+        identity = QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex();
+    }
+
+    QMutexLocker locker(&m_lock);
+    if(mrl == m_mrl)
+        return;
+    ++m_generation;
+    m_mrl = mrl;
+    m_identity = identity;
+    m_interval = 0;
+    m_slots = 0;
+    m_cursor = -1;
+    m_pending.clear();
+    m_sheets.clear();
+    if(!m_thread && !mrl.isEmpty()) {
+        // Below the priority of playback, previews may lag but playback must not.
+        m_thread = QThread::create([this] { run(); });
+        m_thread->start(QThread::LowPriority);
+    }
+    m_wake.wakeAll();
+}
+
+void ThumbnailService::request(qint64 msec) {
+    QImage image;
+    qint64 start{0};
+    {
+        QMutexLocker locker(&m_lock);
+        m_cursor = qMax<qint64>(0, msec);
+        if(!m_slots)
+            return; // The worker queues around the cursor once the source is open.
+        const auto slot{static_cast<int>(qMin<qint64>(m_cursor / m_interval, m_slots - 1))};
+        image = tile(slot);
+        start = slot * m_interval;
+        queueAroundCursor();
+    }
+    if(!image.isNull())
+        emit thumbnailReady(start, image);
+}
+
+QImage ThumbnailService::thumbnail(qint64 msec) {
+    QMutexLocker locker(&m_lock);
+    if(!m_slots || msec < 0)
+        return QImage();
+    return tile(static_cast<int>(qMin<qint64>(msec / m_interval, m_slots - 1)));
+}
+
+int ThumbnailService::byteBudget() const {
+    QMutexLocker locker(&m_lock);
+    return m_sheets.maxCost();
+}
+
+void ThumbnailService::setByteBudget(int bytes) {
+    QMutexLocker locker(&m_lock);
+    m_sheets.setMaxCost(bytes);
+}
+
+bool ThumbnailService::diskCache() const {
+    return m_diskCache;
+}
+
+void ThumbnailService::setDiskCache(bool enabled) {
+    QMutexLocker locker(&m_lock);
+    m_diskCache = enabled;
+}
+
+qint64 ThumbnailService::interval() const {
+    QMutexLocker locker(&m_lock);
+    return m_interval;
+}
+
+void ThumbnailService::queueAroundCursor() {
+    if(!m_slots || m_cursor < 0)
+        return;
+    const auto center{static_cast<int>(qMin<qint64>(m_cursor / m_interval, m_slots - 1))};
+    for(auto slot{qMax(0, center - NEIGHBOURS)}; slot <= qMin(m_slots - 1, center + NEIGHBOURS); slot++) {
+        if(tile(slot).isNull())
+            m_pending.insert(slot);
+    }
+    m_wake.wakeAll();
+}
+
+QString ThumbnailService::sheetPath(int index) const {
+    if(!m_diskCache || m_identity.isEmpty())
+        return QString();
+    return cacheFilePath(QStringLiteral("thumbnails-%1-%2.png").arg(QString::fromLatin1(m_identity)).arg(index));
+}
+
+ThumbnailService::Sheet* ThumbnailService::sheet(int slot, bool create) {
+    const auto index{slot / TILES_PER_SHEET};
+    if(auto cached{m_sheets.object(index)})
+        return cached;
+
+    if(!create)
+        return nullptr;
+
+    auto stored{new Sheet{QImage(TILE_WIDTH * SHEET_COLUMNS, TILE_HEIGHT * SHEET_ROWS, QImage::Format_RGBX8888),
+                          QVector<bool>(TILES_PER_SHEET, false), 0}};
+    stored->image.fill(Qt::black);
+    // The cache deletes sheets exceeding the whole budget right away.
+    m_sheets.insert(index, stored, static_cast<int>(stored->image.sizeInBytes()));
+    return m_sheets.object(index);
+}
+
+QImage ThumbnailService::tile(int slot) {
+    const auto stored{sheet(slot, false)};
+    const auto position{slot % TILES_PER_SHEET};
+    if(!stored || !stored->filled[position])
+        return QImage();
+    return stored->image.copy((position % SHEET_COLUMNS) * TILE_WIDTH, (position / SHEET_COLUMNS) * TILE_HEIGHT,
+                              TILE_WIDTH, TILE_HEIGHT);
+}
+
+bool ThumbnailService::loadSheet(int slot, const QString& path, quint64 generation) {
+    QImage image;
+    if(!QFile::exists(path) || !image.load(path)
+       || image.width() != TILE_WIDTH * SHEET_COLUMNS || image.height() != TILE_HEIGHT * SHEET_ROWS)
+        return false;
+    // Only complete sheets are stored.
+    const auto index{slot / TILES_PER_SHEET};
+    auto stored{new Sheet{image.convertToFormat(QImage::Format_RGBX8888), QVector<bool>(TILES_PER_SHEET, true), TILES_PER_SHEET}};
+    const auto sheetImage{stored->image};
+    // The requested slot and the pending ones of the sheet are answered from it.
+    QList<int> answered{slot};
+    qint64 interval{0};
+    {
+        QMutexLocker locker(&m_lock);
+        if(generation != m_generation) {
+            delete stored;
+            return true;
+        }
+        for(auto it{m_pending.begin()}; it != m_pending.end();) {
+            if(*it / TILES_PER_SHEET == index) {
+                answered.append(*it);
+                it = m_pending.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        interval = m_interval;
+        m_sheets.insert(index, stored, static_cast<int>(stored->image.sizeInBytes()));
+    }
+    for(const auto answer : qAsConst(answered)) {
+        const auto position{answer % TILES_PER_SHEET};
+        emit thumbnailReady(answer * interval, sheetImage.copy((position % SHEET_COLUMNS) * TILE_WIDTH,
+                                                               (position / SHEET_COLUMNS) * TILE_HEIGHT,
+                                                               TILE_WIDTH, TILE_HEIGHT));
+    }
+    return true;
+}
+
+void ThumbnailService::onUpdate(void* opaque) {
+    // Called from mpv, no API calls allowed here.
+    static_cast<ThumbnailService*>(opaque)->m_frame.wakeAll();
+}
+
+bool ThumbnailService::createCore() {
+    // No audio, cheap single threaded decoding, keyframes only
+    if(!(m_core = createHeadlessCore("thumbnail", {
+             {"pause", "yes"},
+             {"keep-open", "always"},
+             {"vo", "libmpv"},
+             {"aid", "no"},
+             {"osd-level", "0"},
+             {"hwdec", "no"},
+             {"hr-seek", "no"},
+             {"vd-lavc-threads", "1"},
+             {"vd-lavc-fast", "yes"},
+             {"vd-lavc-skiploopfilter", "all"},
+             {"sws-scaler", "fast-bilinear"},
+         })))
+        return false;
+    auto err{0};
+    requestEvents(m_core, {MPV_EVENT_FILE_LOADED, MPV_EVENT_END_FILE, MPV_EVENT_PLAYBACK_RESTART});
+
+    mpv_render_param params[]{
+        {MPV_RENDER_PARAM_API_TYPE, const_cast<char*>(MPV_RENDER_API_TYPE_SW)},
+        {MPV_RENDER_PARAM_INVALID, nullptr}
+    };
+    if((err = mpv_render_context_create(&m_render, m_core, params)) < 0) {
+        error() << "Failed to create software render context:" << mpv_error_string(err);
+        mpv_terminate_destroy(m_core);
+        m_core = nullptr;
+        return false;
+    }
+    mpv_render_context_set_update_callback(m_render, onUpdate, this);
+    return true;
+}
+
+bool ThumbnailService::open(const QByteArray& mrl, quint64 generation) {
+    const char* load[]{"loadfile", mrl.constData(), nullptr};
+    if(mpv_command(m_core, load) < 0)
+        return false;
+    QElapsedTimer timer;
+    timer.start();
+    forever {
+        if(generation != m_generation || timer.elapsed() > OPEN_TIMEOUT)
+            return false;
+        const auto event{mpv_wait_event(m_core, 0.1)};
+        if(event->event_id == MPV_EVENT_END_FILE)
+            return false;
+        if(event->event_id == MPV_EVENT_FILE_LOADED)
+            break;
+    }
+    // The restart at the start position must not be taken for the first seek.
+    while(mpv_wait_event(m_core, 0.1)->event_id != MPV_EVENT_PLAYBACK_RESTART) {
+        if(generation != m_generation || timer.elapsed() > OPEN_TIMEOUT)
+            return false;
+    }
+
+    double duration{0};
+    mpv_get_property(m_core, "duration", MPV_FORMAT_DOUBLE, &duration);
+    char* video{mpv_get_property_string(m_core, "vid")};
+    const auto hasVideo{video && strcmp(video, "no")};
+    mpv_free(video);
+    if(duration <= 0 || !hasVideo) {
+        debug() << "No thumbnails for" << mrl;
+        return false;
+    }
+
+    // Short sources get a thumbnail every few seconds, long ones about TARGET_THUMBNAILS.
+    const auto total{static_cast<qint64>(duration * 1000)};
+    const auto interval{qBound(MIN_INTERVAL, total / TARGET_THUMBNAILS, MAX_INTERVAL)};
+    QMutexLocker locker(&m_lock);
+    if(generation != m_generation)
+        return false;
+    m_interval = interval;
+    m_slots = static_cast<int>((total + interval - 1) / interval);
+    queueAroundCursor();
+    debug() << "Thumbnails of" << mrl << "every" << m_interval << "ms," << m_slots << "slots";
+    return true;
+}
+
+bool ThumbnailService::render(int slot, qint64 msec, quint64 generation) {
+    // Forget the frame shown so far, only the one of this seek counts.
+    mpv_render_context_update(m_render);
+    const auto target{QByteArray::number(msec / 1000.0, 'f', 3)};
+    const char* seek[]{"seek", target.constData(), "absolute+keyframes", nullptr};
+    if(mpv_command(m_core, seek) < 0)
+        return false;
+
+    QElapsedTimer timer;
+    timer.start();
+    forever {
+        if(generation != m_generation || timer.elapsed() > FRAME_TIMEOUT)
+            return false;
+        if(mpv_wait_event(m_core, 0.1)->event_id == MPV_EVENT_PLAYBACK_RESTART)
+            break;
+    }
+    {
+        QMutexLocker locker(&m_frameLock);
+        while(!(mpv_render_context_update(m_render) & MPV_RENDER_UPDATE_FRAME)) {
+            if(generation != m_generation || timer.elapsed() > FRAME_TIMEOUT)
+                return false;
+            m_frame.wait(&m_frameLock, 20);
+        }
+    }
+
+    // The software renderer scales into the tile size, no full size frame is copied.
+    QImage image(TILE_WIDTH, TILE_HEIGHT, QImage::Format_RGBX8888);
+    int size[]{TILE_WIDTH, TILE_HEIGHT};
+    size_t stride{static_cast<size_t>(image.bytesPerLine())};
+    mpv_render_param params[]{
+        {MPV_RENDER_PARAM_SW_SIZE, size},
+        {MPV_RENDER_PARAM_SW_FORMAT, const_cast<char*>("rgb0")},
+        {MPV_RENDER_PARAM_SW_STRIDE, &stride},
+        {MPV_RENDER_PARAM_SW_POINTER, image.bits()},
+        {MPV_RENDER_PARAM_INVALID, nullptr}
+    };
+    auto err{0};
+    if((err = mpv_render_context_render(m_render, params)) < 0) {
+        warning() << "Failed to render thumbnail:" << mpv_error_string(err);
+        return false;
+    }
+
+    QImage complete;
+    QString path;
+    {
+        QMutexLocker locker(&m_lock);
+        if(generation != m_generation)
+            return false;
+        if(auto stored{sheet(slot, true)}) {
+            const auto position{slot % TILES_PER_SHEET};
+            const auto x{(position % SHEET_COLUMNS) * TILE_WIDTH};
+            const auto y{(position / SHEET_COLUMNS) * TILE_HEIGHT};
+            for(auto line{0}; line < TILE_HEIGHT; line++)
+                memcpy(stored->image.scanLine(y + line) + x * 4, image.constScanLine(line), TILE_WIDTH * 4);
+            if(!stored->filled[position]) {
+                stored->filled[position] = true;
+                stored->count++;
+            }
+            // The last sheet of a source may have fewer tiles.
+            const auto tiles{qMin(TILES_PER_SHEET, m_slots - slot / TILES_PER_SHEET * TILES_PER_SHEET)};
+            if(stored->count == tiles && !(path = sheetPath(slot / TILES_PER_SHEET)).isEmpty())
+                complete = stored->image;
+        }
+    }
+    // Encoding takes a while, request() must not wait for it. The copy shares the pixels,
+    // writing the next tile detaches the sheet.
+    if(!complete.isNull() && !complete.save(path, "PNG"))
+        warning() << "Failed to store thumbnails in" << path;
+    emit thumbnailReady(msec, image);
+    return true;
+}
+
+void ThumbnailService::run() {
+    quint64 opened{0};
+    auto ready{false};
+    QMutexLocker locker(&m_lock);
+    while(!m_stopping) {
+        const auto generation{m_generation.load()};
+        if(opened != generation) {
+            const auto mrl{m_mrl};
+            locker.unlock();
+            ready = !mrl.isEmpty() && (m_core || createCore()) && open(mrl, generation);
+            locker.relock();
+            opened = generation;
+            continue;
+        }
+        if(!ready || m_pending.isEmpty()) {
+            m_wake.wait(&m_lock);
+            continue;
+        }
+
+        // Nearest to the cursor first, it is what the user looks at.
+        const auto center{m_cursor / m_interval};
+        auto next{*m_pending.cbegin()};
+        for(const auto slot : m_pending) {
+            if(qAbs(slot - center) < qAbs(next - center))
+                next = slot;
+        }
+        m_pending.remove(next);
+        const auto msec{next * m_interval};
+        // A sheet that is not in memory may be on disk, reading it beats rendering it.
+        const auto path{m_sheets.contains(next / TILES_PER_SHEET) ? QString() : sheetPath(next / TILES_PER_SHEET)};
+        locker.unlock();
+        if(path.isEmpty() || !loadSheet(next, path, generation))
+            render(next, msec, generation);
+        locker.relock();
+    }
+    locker.unlock();
+
+    if(m_render)
+        mpv_render_context_free(m_render);
+    if(m_core)
+        mpv_terminate_destroy(m_core);
+}
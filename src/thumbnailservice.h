@@ -0,0 +1,147 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_MPV_THUMBNAILSERVICE_H
+#define PHONON_MPV_THUMBNAILSERVICE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <atomic>
+
+class QThread;
+struct mpv_handle;
+struct mpv_render_context;
+
+namespace Phonon::MPV {
+
+    /** \brief Seek bar hover previews of the source of a MediaObject
+    *
+    * Thumbnails come from a shadow core of their own, so the playing core is never seeked
+    * or paused for them. The shadow core has no audio, decodes on one thread and renders
+    * with the software render API (MPV_RENDER_API_TYPE_SW) straight into the thumbnail
+    * size, no GPU involved.
+    *
+    * The duration is split into slots of an interval adapted to its length, every slot gets
+    * one thumbnail from a keyframe seek. Thumbnails are packed into sprite sheets, kept in
+    * memory within a byte budget with the least recently used sheets dropped first. Complete
+    * sheets of local files can be stored in the cache directory.
+    *
+    * Pending slots are rendered nearest to the last requested position first.
+    */
+    class ThumbnailService : public QObject {
+        Q_OBJECT
+        /// Bytes of sprite sheets kept in memory
+        Q_PROPERTY(int byteBudget READ byteBudget WRITE setByteBudget)
+        /// Whether complete sheets of local files are stored in and loaded from the cache directory
+        Q_PROPERTY(bool diskCache READ diskCache WRITE setDiskCache)
+        /// Milliseconds between thumbnails of the current source, 0 until it is known
+        Q_PROPERTY(qint64 interval READ interval)
+
+    public:
+        explicit ThumbnailService(QObject* parent = nullptr);
+        ~ThumbnailService() Q_DECL_OVERRIDE;
+
+        /// Drops all thumbnails and prepares \p mrl instead, an empty one stops the service.
+        void setSource(const QByteArray& mrl);
+
+        /**
+        * Requests the thumbnail at \p msec, e.g. the hover position. A known thumbnail is
+        * reported by thumbnailReady() right away, otherwise it and its neighbours are rendered
+        * before any slot farther away.
+        */
+        Q_INVOKABLE void request(qint64 msec);
+
+        /// \return The thumbnail of the slot containing \p msec, a null image if it is not rendered or loaded yet.
+        Q_INVOKABLE QImage thumbnail(qint64 msec);
+
+        int byteBudget() const;
+        void setByteBudget(int bytes);
+        bool diskCache() const;
+        void setDiskCache(bool enabled);
+        qint64 interval() const;
+
+    Q_SIGNALS:
+        /// The thumbnail of the slot starting at \p msec was rendered, from the worker thread.
+        void thumbnailReady(qint64 msec, const QImage& image);
+
+    private:
+        struct Sheet {
+            QImage image;
+            /// Tiles rendered so far, a bit per tile
+            QVector<bool> filled;
+            int count;
+        };
+
+        /// Worker thread, loads the source and renders pending slots.
+        void run();
+        /// Creates m_core and m_render on the worker. \return \c false if that failed.
+        bool createCore();
+        /// Loads \p mrl paused and computes the interval. \return \c false if it has no video or duration.
+        bool open(const QByteArray& mrl, quint64 generation);
+        /// Seeks to \p msec and renders slot \p slot into its sheet. \return \c false if the frame did not show up.
+        bool render(int slot, qint64 msec, quint64 generation);
+        /// Adds the slot at m_cursor and its neighbours to m_pending. Needs m_lock.
+        void queueAroundCursor();
+
+        /// \return The sheet of \p slot, a new one if \p create is set, otherwise nullptr if it is not in memory. Needs m_lock.
+        Sheet* sheet(int slot, bool create);
+        /**
+        * Reads the sheet of \p slot from \p path without holding m_lock and answers the pending
+        * slots it contains. \return \c false if there is no usable sheet stored.
+        */
+        bool loadSheet(int slot, const QString& path, quint64 generation);
+        /// \return The cache file of sheet \p index, empty if the source can not be cached. Needs m_lock.
+        QString sheetPath(int index) const;
+        /// \return The tile of \p slot, a null image if it is not rendered yet. Needs m_lock.
+        QImage tile(int slot);
+
+        static void onUpdate(void* opaque);
+
+        QThread* m_thread;
+        mpv_handle* m_core;
+        mpv_render_context* m_render;
+        /// Signalled by onUpdate() when the shadow core has a new frame
+        QMutex m_frameLock;
+        QWaitCondition m_frame;
+
+        /// Guards everything below, shared by the GUI and the worker thread
+        mutable QMutex m_lock;
+        QWaitCondition m_wake;
+        QByteArray m_mrl;
+        /// Identifies the cache files of the source, empty if it is no local file
+        QByteArray m_identity;
+        /// Bumped with every source change, work of an older generation is dropped
+        std::atomic<quint64> m_generation;
+        bool m_stopping;
+        qint64 m_interval;
+        int m_slots;
+        qint64 m_cursor;
+        QSet<int> m_pending;
+        QCache<int, Sheet> m_sheets;
+        bool m_diskCache;
+    };
+
+} // namespace Phonon::MPV
+
+#endif // PHONON_MPV_THUMBNAILSERVICE_H
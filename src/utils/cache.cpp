@@ -0,0 +1,33 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "cache.h"
+
+#include <QDir>
+#include <QStandardPaths>
+
+#include "debug.h"
+
+QString Phonon::MPV::cacheFilePath(const QString& name) {
+    const QDir directory{QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+                         + QLatin1String("/phonon-mpv")};
+    if(!directory.mkpath(QStringLiteral("."))) {
+        warning() << "Failed to create cache directory" << directory.path();
+        return QString();
+    }
+    return directory.filePath(name);
+}
@@ -0,0 +1,34 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_MPV_CACHE_H
+#define PHONON_MPV_CACHE_H
+
+#include <QString>
+
+namespace Phonon::MPV {
+
+    /**
+    * \return The path of the cache file \p name of the backend, below the generic cache
+    * location (e.g. ~/.cache/phonon-mpv). The directory is created on demand, an empty
+    * string is returned if that fails.
+    */
+    QString cacheFilePath(const QString& name);
+
+} // namespace Phonon::MPV
+
+#endif // PHONON_MPV_CACHE_H
@@ -0,0 +1,82 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "envelope.h"
+
+#include <QtGlobal>
+
+#include <cmath>
+
+// Lanes of the reduction kernel, independent accumulators the compiler maps to vector registers
+static const int LANES = 8;
+
+static qint16 quantize(double value) {
+    return static_cast<qint16>(qBound(-32767.0, std::round(value * 32767), 32767.0));
+}
+
+void Phonon::MPV::reduce(const float* samples, int count, EnvelopeBlock* block) {
+    if(!block->samples && count > 0)
+        block->min = block->max = samples[0];
+    float low[LANES], high[LANES], squares[LANES];
+    for(auto lane{0}; lane < LANES; lane++) {
+        low[lane] = block->min;
+        high[lane] = block->max;
+        squares[lane] = 0;
+    }
+    auto i{0};
+    for(; i + LANES <= count; i += LANES) {
+        for(auto lane{0}; lane < LANES; lane++) {
+            const auto sample{samples[i + lane]};
+            low[lane] = sample < low[lane] ? sample : low[lane];
+            high[lane] = sample > high[lane] ? sample : high[lane];
+            squares[lane] += sample * sample;
+        }
+    }
+    for(; i < count; i++) {
+        low[0] = qMin(low[0], samples[i]);
+        high[0] = qMax(high[0], samples[i]);
+        squares[0] += samples[i] * samples[i];
+    }
+    for(auto lane{0}; lane < LANES; lane++) {
+        block->min = qMin(block->min, low[lane]);
+        block->max = qMax(block->max, high[lane]);
+        block->squares += squares[lane];
+    }
+    block->samples += count;
+}
+
+QByteArray Phonon::MPV::envelope(const std::vector<EnvelopeBlock>& blocks, int buckets) {
+    QByteArray result(buckets * 3 * static_cast<int>(sizeof(qint16)), Qt::Uninitialized);
+    auto out{reinterpret_cast<qint16*>(result.data())};
+    const auto total{static_cast<qint64>(blocks.size())};
+    for(auto bucket{0}; bucket < buckets; bucket++) {
+        // Short files repeat blocks rather than leaving buckets empty.
+        const auto first{bucket * total / buckets};
+        const auto last{qMax(first + 1, (bucket + 1) * total / buckets)};
+        EnvelopeBlock merged{blocks[first].min, blocks[first].max, 0, 0};
+        for(auto i{first}; i < last && i < total; i++) {
+            merged.min = qMin(merged.min, blocks[i].min);
+            merged.max = qMax(merged.max, blocks[i].max);
+            merged.squares += blocks[i].squares;
+            merged.samples += blocks[i].samples;
+        }
+        *out++ = quantize(merged.min);
+        *out++ = quantize(merged.max);
+        *out++ = quantize(merged.samples ? std::sqrt(merged.squares / merged.samples) : 0);
+    }
+    return result;
+}
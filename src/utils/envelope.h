@@ -0,0 +1,46 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_MPV_ENVELOPE_H
+#define PHONON_MPV_ENVELOPE_H
+
+#include <QByteArray>
+
+#include <vector>
+
+namespace Phonon::MPV {
+
+    /// Minimum, maximum and sum of squares of a run of samples
+    struct EnvelopeBlock {
+        float min;
+        float max;
+        double squares;
+        int samples;
+    };
+
+    /// Reduces \p count samples into \p block, which may already hold earlier samples.
+    void reduce(const float* samples, int count, EnvelopeBlock* block);
+
+    /**
+    * Merges \p blocks (at least one) into \p buckets envelope buckets of \c qint16 (min, max, RMS)
+    * triplets, scaled so that 32767 is full scale. With fewer blocks than buckets blocks repeat.
+    */
+    QByteArray envelope(const std::vector<EnvelopeBlock>& blocks, int buckets);
+
+} // namespace Phonon::MPV
+
+#endif // PHONON_MPV_ENVELOPE_H
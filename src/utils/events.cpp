@@ -0,0 +1,31 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "events.h"
+
+#include <algorithm>
+
+// Above the highest event id of any libmpv release
+static const int MAX_EVENT_ID = 32;
+
+void Phonon::MPV::requestEvents(mpv_handle* handle, std::initializer_list<mpv_event_id> events) {
+    for(auto id{1}; id <= MAX_EVENT_ID; id++) {
+        const auto enable{std::find(events.begin(), events.end(), id) != events.end()};
+        // Unknown ids are rejected by libmpv, which is fine.
+        mpv_request_event(handle, static_cast<mpv_event_id>(id), enable);
+    }
+}
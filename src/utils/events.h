@@ -0,0 +1,38 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_MPV_EVENTS_H
+#define PHONON_MPV_EVENTS_H
+
+#include <initializer_list>
+
+#ifndef MPV_ENABLE_DEPRECATED
+#define MPV_ENABLE_DEPRECATED 0
+#endif
+#include <mpv/client.h>
+
+namespace Phonon::MPV {
+
+    /**
+    * Enables delivery of \p events on \p handle and disables every other event, so the
+    * queue of a client only fills with what its owner handles.
+    */
+    void requestEvents(mpv_handle* handle, std::initializer_list<mpv_event_id> events);
+
+} // namespace Phonon::MPV
+
+#endif // PHONON_MPV_EVENTS_H
@@ -0,0 +1,70 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_MPV_SPSCQUEUE_H
+#define PHONON_MPV_SPSCQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace Phonon::MPV {
+
+    /** \brief Bounded lock-free single producer, single consumer ring buffer
+    *
+    * push() must only ever be called from one thread and pop() from one other thread.
+    * Slots are preallocated, items are moved in and out of them.
+    */
+    template<typename T, std::size_t Capacity>
+    class SpscQueue {
+        static_assert(Capacity && !(Capacity & (Capacity - 1)), "Capacity must be a power of two");
+
+    public:
+        /// \returns \c false if the queue is full, the item is left untouched in that case
+        bool push(T&& item) {
+            const auto tail{m_tail.load(std::memory_order_relaxed)};
+            if(tail - m_head.load(std::memory_order_acquire) == Capacity)
+                return false;
+            m_items[tail & (Capacity - 1)] = std::move(item);
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// \returns \c false if the queue is empty
+        bool pop(T& item) {
+            const auto head{m_head.load(std::memory_order_relaxed)};
+            if(head == m_tail.load(std::memory_order_acquire))
+                return false;
+            item = std::move(m_items[head & (Capacity - 1)]);
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool isFull() const {
+            return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire) == Capacity;
+        }
+
+    private:
+        alignas(64) std::atomic<std::size_t> m_head{0};
+        alignas(64) std::atomic<std::size_t> m_tail{0};
+        std::array<T, Capacity> m_items;
+    };
+
+} // namespace Phonon::MPV
+
+#endif // PHONON_MPV_SPSCQUEUE_H
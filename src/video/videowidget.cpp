@@ -23,7 +23,6 @@
 
 #include <QtGui/QPainter>
 #include <QtGui/QPaintEvent>
-#include <QDir>
 #include <QOpenGLContext>
 #include <QGuiApplication>
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
@@ -36,6 +35,8 @@
 #define MPV_ENABLE_DEPRECATED 0
 #include <mpv/render_gl.h>
 
+#include <cstring>
+
 #include "utils/debug.h"
 #include "mediaobject.h"
 
@@ -139,6 +140,7 @@ VideoWidget::VideoWidget(QWidget* parent) :
     m_hue(0.0),
     m_saturation(0.0),
     mpv_gl(nullptr) {
+    m_snapshots.setMaxThreadCount(1);
     // We want background painting so Qt autofills with black.
     setAttribute(Qt::WA_NoSystemBackground, false);
 
@@ -153,6 +155,7 @@ VideoWidget::VideoWidget(QWidget* parent) :
 }
 
 VideoWidget::~VideoWidget() {
+    m_snapshots.waitForDone();
     if(mpv_gl)
         mpv_render_context_free(mpv_gl);
 }
@@ -166,12 +169,27 @@ void VideoWidget::handleConnectToMediaObject(MediaObject* mediaObject) {
     connect(mediaObject, SIGNAL(currentSourceChanged(MediaSource)),
             SLOT(clearPendingAdjusts()));
     clearPendingAdjusts();
+    // Every MediaObject has a core of its own, render the new one.
+    if(isValid() && !mpv_gl) {
+        makeCurrent();
+        initializeGL();
+        doneCurrent();
+    }
 }
 
 void VideoWidget::handleDisconnectFromMediaObject(MediaObject* mediaObject) {
     // Undo all connections or path creation->destruction->creation can cause
     // duplicated connections or getting singals from two different MediaObjects.
     disconnect(mediaObject, 0, this, 0);
+    // Snapshots in flight use the client of the MediaObject.
+    m_snapshots.waitForDone();
+    // The core of the MediaObject is recycled, the render context must not outlive it.
+    if(mpv_gl) {
+        makeCurrent();
+        mpv_render_context_free(mpv_gl);
+        mpv_gl = nullptr;
+        doneCurrent();
+    }
 }
 
 Phonon::VideoWidget::AspectRatio VideoWidget::aspectRatio() const {
@@ -188,7 +206,8 @@ void VideoWidget::setAspectRatio(Phonon::VideoWidget::AspectRatio aspect) {
 
     switch(m_aspectRatio) {
         case Phonon::VideoWidget::AspectRatioAuto:
-            ratio = 1.f;
+            // Aspect of the video itself, also what the CorePool restores.
+            ratio = -1.f;
             break;
         case Phonon::VideoWidget::AspectRatio4_3:
             ratio = 4.f / 3.f;
@@ -200,10 +219,8 @@ void VideoWidget::setAspectRatio(Phonon::VideoWidget::AspectRatio aspect) {
             ratio = static_cast<double>(width()) / height();
             break;
     }
-    if(ratio) {
-        auto err{0};
-        if((err = mpv_set_property(m_player, "video-aspect", MPV_FORMAT_DOUBLE, &ratio)))
-            warning() << "Failed to set ratio" << aspect << ":" << mpv_error_string(err);
+    if(ratio && m_mediaObject) {
+        m_mediaObject->requests().setProperty("video-aspect-override", ratio);
     } else {
         warning() << "The aspect ratio" << aspect << "is not supported by Phonon MPV.";
     }
@@ -235,10 +252,7 @@ void VideoWidget::setBrightness(qreal brightness) {
     }
 
     m_brightness = brightness;
-    int64_t bright{static_cast<int64_t>(brightness * 100)};
-    auto err{0};
-    if((err = mpv_set_property(m_player, "brightness", MPV_FORMAT_INT64, &bright)))
-        warning() << "Failed to set brightness:" << mpv_error_string(err);
+    m_mediaObject->requests().setProperty("brightness", static_cast<qint64>(brightness * 100));
 }
 
 qreal VideoWidget::contrast() const {
@@ -256,10 +270,7 @@ void VideoWidget::setContrast(qreal contrast) {
     }
 
     m_contrast = contrast;
-    int64_t cont{static_cast<int64_t>(contrast * 100)};
-    auto err{0};
-    if((err = mpv_set_property(m_player, "contrast", MPV_FORMAT_INT64, &cont)))
-        warning() << "Failed to set contrast:" << mpv_error_string(err);
+    m_mediaObject->requests().setProperty("contrast", static_cast<qint64>(contrast * 100));
 }
 
 qreal VideoWidget::hue() const {
@@ -277,10 +288,7 @@ void VideoWidget::setHue(qreal hue) {
     }
 
     m_hue = hue;
-    int64_t hueval{static_cast<int64_t>(hue * 100)};
-    auto err{0};
-    if((err = mpv_set_property(m_player, "hue", MPV_FORMAT_INT64, &hueval)))
-        warning() << "Failed to set hue:" << mpv_error_string(err);
+    m_mediaObject->requests().setProperty("hue", static_cast<qint64>(hue * 100));
 }
 
 qreal VideoWidget::saturation() const {
@@ -299,10 +307,7 @@ void VideoWidget::setSaturation(qreal saturation) {
     }
 
     m_saturation = saturation;
-    int64_t sat{static_cast<int64_t>(saturation * 100)};
-    auto err{0};
-    if((err = mpv_set_property(m_player, "saturation", MPV_FORMAT_INT64, &sat)))
-        warning() << "Failed to set saturation:" << mpv_error_string(err);
+    m_mediaObject->requests().setProperty("saturation", static_cast<qint64>(saturation * 100));
 }
 
 QWidget* VideoWidget::widget() {
@@ -361,16 +366,99 @@ bool VideoWidget::enableFilterAdjust(bool adjust) {
 
 QImage VideoWidget::snapshot() const {
     DEBUG_BLOCK;
-    if (m_player) {
-        const auto path{(QDir::tempPath() + "/" + QStringLiteral("phonon-mpv-snapshot")).toUtf8()};
-        const char* cmd[]{"screenshot-to-file", path.constData(), nullptr};
-        auto err{0};
-        if((err = mpv_command(m_player, cmd))) {
-            warning() << "Failed to take screenshot:" << mpv_error_string(err);
-            return QImage();
+    return snapshot(QStringLiteral("video"));
+}
+
+QImage VideoWidget::snapshot(const QString& mode) const {
+    if(!m_player)
+        return QImage();
+    return screenshot(m_player, mode.toUtf8());
+}
+
+void VideoWidget::requestSnapshot(const QString& mode) {
+    if(!m_player) {
+        emit snapshotTaken(QImage());
+        return;
+    }
+    const auto player{m_player};
+    const auto flags{mode.toUtf8()};
+    m_snapshots.start([this, player, flags] { emit snapshotTaken(screenshot(player, flags)); });
+}
+
+QImage VideoWidget::screenshot(mpv_handle* player, const QByteArray& mode) {
+    const char* args[]{"screenshot-raw", mode.constData()};
+    mpv_node values[2];
+    for(auto i{0}; i < 2; i++) {
+        values[i].format = MPV_FORMAT_STRING;
+        values[i].u.string = const_cast<char*>(args[i]);
+    }
+    mpv_node_list list{2, values, nullptr};
+    mpv_node command;
+    command.format = MPV_FORMAT_NODE_ARRAY;
+    command.u.list = &list;
+
+    // The image keeps the node alive and frees it once the last copy is gone.
+    auto result{new mpv_node};
+    auto err{0};
+    if((err = mpv_command_node(player, &command, result)) < 0) {
+        warning() << "Failed to take screenshot:" << mpv_error_string(err);
+        delete result;
+        return QImage();
+    }
+
+    int64_t width{0}, height{0}, stride{0};
+    const char* format{nullptr};
+    mpv_byte_array* data{nullptr};
+    if(result->format == MPV_FORMAT_NODE_MAP) {
+        for(auto i{0}; i < result->u.list->num; i++) {
+            const auto key{result->u.list->keys[i]};
+            const auto& value{result->u.list->values[i]};
+            if(!strcmp(key, "w") && value.format == MPV_FORMAT_INT64)
+                width = value.u.int64;
+            else if(!strcmp(key, "h") && value.format == MPV_FORMAT_INT64)
+                height = value.u.int64;
+            else if(!strcmp(key, "stride") && value.format == MPV_FORMAT_INT64)
+                stride = value.u.int64;
+            else if(!strcmp(key, "format") && value.format == MPV_FORMAT_STRING)
+                format = value.u.string;
+            else if(!strcmp(key, "data") && value.format == MPV_FORMAT_BYTE_ARRAY)
+                data = value.u.ba;
         }
-        return QImage(QDir::tempPath() + "/" + QStringLiteral("phonon-mpv-snapshot"));
-    } else {
+    }
+
+    auto imageFormat{QImage::Format_Invalid};
+    if(format && !strcmp(format, "bgr0"))
+        imageFormat = QImage::Format_RGB32;
+    else if(format && !strcmp(format, "bgra"))
+        imageFormat = QImage::Format_ARGB32_Premultiplied;
+    else if(format && !strcmp(format, "rgba"))
+        imageFormat = QImage::Format_RGBA8888_Premultiplied;
+    if(!data || width <= 0 || height <= 0 || stride < width * 4 || imageFormat == QImage::Format_Invalid
+       || static_cast<int64_t>(data->size) < stride * height) {
+        warning() << "Unusable screenshot, format" << (format ? format : "none");
+        mpv_free_node_contents(result);
+        delete result;
         return QImage();
     }
+
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    // Qt's 32 bit formats are native words, bgr0 and bgra are bytes in this order. Taken as the
+    // byte ordered RGB formats only red and blue are swapped.
+    const auto swapped{imageFormat != QImage::Format_RGBA8888_Premultiplied};
+    if(imageFormat == QImage::Format_RGB32)
+        imageFormat = QImage::Format_RGBX8888;
+    else if(imageFormat == QImage::Format_ARGB32_Premultiplied)
+        imageFormat = QImage::Format_RGBA8888_Premultiplied;
+#endif
+    const QImage image(static_cast<const uchar*>(data->data), static_cast<int>(width), static_cast<int>(height),
+                       static_cast<qsizetype>(stride), imageFormat,
+                       [](void* node) {
+                           mpv_free_node_contents(static_cast<mpv_node*>(node));
+                           delete static_cast<mpv_node*>(node);
+                       }, result);
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    if(swapped)
+        return image.rgbSwapped();
+#endif
+    return image;
 }
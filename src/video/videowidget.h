@@ -23,6 +23,7 @@
 #define PHONON_MPV_VIDEOWIDGET_H
 
 #include <QOpenGLWidget>
+#include <QThreadPool>
 
 #include <phonon/videowidgetinterface.h>
 
@@ -142,6 +143,22 @@ namespace Phonon::MPV {
         /// \reimp
         QSize sizeHint() const Q_DECL_OVERRIDE;
 
+        /**
+        * \return The current frame in \p mode, "video" for the decoded frame, "subtitles" with
+        * subtitles rendered in or "window" as shown in the widget, scaled and with OSD. The
+        * image shares the memory mpv returned, nothing is encoded or written to disk.
+        */
+        Q_INVOKABLE QImage snapshot(const QString& mode) const;
+
+        /**
+        * Takes a snapshot() in \p mode on a worker thread, large frames do not stall the GUI.
+        * snapshotTaken() delivers it, a null image if it failed.
+        */
+        Q_INVOKABLE void requestSnapshot(const QString& mode = QStringLiteral("video"));
+
+    Q_SIGNALS:
+        void snapshotTaken(const QImage& image);
+
     private slots:
         /// Updates the sizeHint to match the native size of the video.
         /// \param hasVideo \c true when there is a video, \c false otherwise
@@ -181,10 +198,14 @@ namespace Phonon::MPV {
         static void onUpdate(void *ctx);
 
         /**
-        * \return The snapshot of the current video frame.
+        * \return The snapshot of the current video frame, the decoded frame without subtitles
+        * (snapshot("video")). Use snapshot("subtitles") to have them rendered in.
         */
         QImage snapshot() const Q_DECL_OVERRIDE;
 
+        /// Runs screenshot-raw in \p mode on \p player and wraps the returned frame.
+        static QImage screenshot(mpv_handle* player, const QByteArray& mode);
+
         /**
         * Pending video adjusts the application tried to set before we actually
         * had a video to set them on.
@@ -206,6 +227,8 @@ namespace Phonon::MPV {
         qreal m_saturation;
     
         mpv_render_context *mpv_gl;
+        /// Thread of requestSnapshot(), drained before m_player goes away
+        QThreadPool m_snapshots;
     };
 
 } // namespace Phonon::MPV
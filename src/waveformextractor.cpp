@@ -0,0 +1,262 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "waveformextractor.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+
+#define MPV_ENABLE_DEPRECATED 0
+#include <mpv/client.h>
+
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "corepool.h"
+#include "utils/cache.h"
+#include "utils/debug.h"
+#include "utils/envelope.h"
+#include "utils/events.h"
+
+// Identifies the cache file format, bump on changes.
+static const quint32 CACHE_MAGIC = 0x70687766; // "phwf"
+static const quint32 CACHE_VERSION = 1;
+// Samples reduced into one intermediate bucket, the envelope is built from these once the
+// amount of samples is known
+static const int BLOCK_SAMPLES = 256;
+// Milliseconds the worker waits for samples before it checks for the end of the file
+static const int POLL_INTERVAL = 50;
+
+using namespace Phonon::MPV;
+
+WaveformExtractor::WaveformExtractor(QObject* parent)
+    : QObject(parent)
+    , m_stopping(false)
+    , m_generation(0) {
+    // Decoding is CPU bound, leave room for playback.
+    m_workers.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+}
+
+WaveformExtractor::~WaveformExtractor() {
+    m_stopping = true;
+    m_workers.clear();
+    m_workers.waitForDone();
+}
+
+QString WaveformExtractor::cachePath(const QUrl& url, int buckets, qint64* size, qint64* modified) {
+    const QFileInfo info{url.toLocalFile()};
+    if(!url.isLocalFile() || !info.isFile())
+        return QString();
+    *size = info.size();
+    *modified = info.lastModified().toMSecsSinceEpoch();
+    const auto hash{QCryptographicHash::hash(QFile::encodeName(info.absoluteFilePath()), QCryptographicHash::Sha1)};
+    return cacheFilePath(QStringLiteral("waveform-%1-%2").arg(QString::fromLatin1(hash.toHex())).arg(buckets));
+}
+
+QByteArray WaveformExtractor::cached(const QUrl& url, int buckets) const {
+    qint64 size, modified;
+    const auto path{cachePath(url, buckets, &size, &modified)};
+    QFile file{path};
+    if(path.isEmpty() || buckets <= 0 || !file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    QDataStream stream{&file};
+    quint32 magic{0}, version{0};
+    qint64 cachedSize{0}, cachedModified{0};
+    qint32 cachedBuckets{0};
+    stream >> magic >> version >> cachedSize >> cachedModified >> cachedBuckets;
+    if(magic != CACHE_MAGIC || version != CACHE_VERSION || cachedSize != size
+       || cachedModified != modified || cachedBuckets != buckets)
+        return QByteArray();
+    QByteArray envelope(buckets * 3 * static_cast<int>(sizeof(qint16)), Qt::Uninitialized);
+    if(stream.readRawData(envelope.data(), envelope.size()) != envelope.size())
+        return QByteArray();
+    return envelope;
+}
+
+void WaveformExtractor::cancel() {
+    ++m_generation;
+}
+
+void WaveformExtractor::request(const QUrl& url, int buckets) {
+    const auto envelope{cached(url, buckets)};
+    if(!envelope.isEmpty()) {
+        emit ready(url, envelope);
+        return;
+    }
+    qint64 size, modified;
+    const auto path{cachePath(url, buckets, &size, &modified)};
+    if(path.isEmpty() || buckets <= 0) {
+        emit failed(url, QStringLiteral("Not a local file"));
+        return;
+    }
+    QMutexLocker locker(&m_lock);
+    if(m_running.contains(path))
+        return;
+    m_running.insert(path);
+    const auto generation{m_generation.load()};
+    m_workers.start([this, url, buckets, generation] { extract(url, buckets, generation); });
+}
+
+void WaveformExtractor::extract(const QUrl& url, int buckets, quint64 generation) {
+    static std::atomic<int> fifoCount{0};
+    QElapsedTimer timer;
+    timer.start();
+    qint64 size, modified;
+    const auto path{cachePath(url, buckets, &size, &modified)};
+    QString failure;
+    std::vector<EnvelopeBlock> blocks;
+
+    const auto fifo{QFile::encodeName(QDir::temp().filePath(QStringLiteral("phonon-mpv-waveform-%1-%2")
+                                          .arg(QCoreApplication::applicationPid()).arg(++fifoCount)))};
+    auto fd{-1};
+    mpv_handle* core{nullptr};
+    auto err{0};
+    if(mkfifo(fifo.constData(), 0600)) {
+        failure = QStringLiteral("Failed to create a FIFO");
+    } else if((fd = ::open(fifo.constData(), O_RDWR | O_NONBLOCK | O_CLOEXEC)) < 0) {
+        // Holding the write end as well makes reads wait for mpv instead of reporting EOF
+        // before its output opened the FIFO.
+        failure = QStringLiteral("Failed to open the FIFO");
+    } else if(!(core = createHeadlessCore("decoding", {
+                   // Mono float samples to the FIFO, as fast as they decode
+                   {"vid", "no"},
+                   {"cache", "no"},
+                   {"untimed", "yes"},
+                   {"ao", "pcm"},
+                   {"ao-pcm-waveheader", "no"},
+                   {"ao-pcm-file", fifo.constData()},
+                   {"audio-format", "float"},
+                   {"audio-channels", "mono"},
+               }))) {
+        failure = QStringLiteral("Failed to create a decoding core");
+    }
+
+    if(generation != m_generation || m_stopping) {
+        failure = QStringLiteral("Cancelled");
+    } else if(failure.isEmpty()) {
+        requestEvents(core, {MPV_EVENT_END_FILE});
+        const auto mrl{url.toEncoded()};
+        const char* load[]{"loadfile", mrl.constData(), nullptr};
+        if((err = mpv_command(core, load)) < 0)
+            failure = QString::fromUtf8(mpv_error_string(err));
+    }
+
+    if(failure.isEmpty()) {
+        float block[BLOCK_SAMPLES];
+        auto filled{0};
+        // Raw bytes, reads may end within a sample.
+        alignas(float) char buffer[64 * 1024];
+        auto carry{0};
+        auto ended{false}, cancelled{false};
+        forever {
+            pollfd readable{fd, POLLIN, 0};
+            poll(&readable, 1, ended ? 0 : POLL_INTERVAL);
+            ssize_t got{0};
+            while((got = ::read(fd, buffer + carry, sizeof(buffer) - carry)) > 0) {
+                if(cancelled)
+                    continue;
+                const auto bytes{carry + static_cast<int>(got)};
+                const auto samples{bytes / static_cast<int>(sizeof(float))};
+                const auto data{reinterpret_cast<const float*>(buffer)};
+                for(auto i{0}; i < samples;) {
+                    const auto take{qMin(samples - i, BLOCK_SAMPLES - filled)};
+                    memcpy(block + filled, data + i, take * sizeof(float));
+                    filled += take;
+                    i += take;
+                    if(filled == BLOCK_SAMPLES) {
+                        EnvelopeBlock reduced{0, 0, 0, 0};
+                        reduce(block, filled, &reduced);
+                        blocks.push_back(reduced);
+                        filled = 0;
+                    }
+                }
+                carry = bytes - samples * static_cast<int>(sizeof(float));
+                memmove(buffer, buffer + samples * sizeof(float), carry);
+            }
+            if(ended)
+                break;
+            if(!cancelled && (m_stopping || generation != m_generation)) {
+                // The output blocks while the FIFO is full and the core can not be destroyed
+                // before it returns, so keep reading until the stopped file ended. A synchronous
+                // stop would wait for the output as well.
+                const char* stop[]{"stop", nullptr};
+                mpv_command_async(core, 0, stop);
+                cancelled = true;
+            }
+            const auto event{mpv_wait_event(core, 0)};
+            if(event->event_id == MPV_EVENT_END_FILE) {
+                // Drain what the output wrote before the file ended, then stop.
+                const auto end{static_cast<mpv_event_end_file*>(event->data)};
+                if(end->reason == MPV_END_FILE_REASON_ERROR && !cancelled)
+                    failure = QString::fromUtf8(mpv_error_string(end->error));
+                ended = true;
+            }
+        }
+        if(filled) {
+            EnvelopeBlock reduced{0, 0, 0, 0};
+            reduce(block, filled, &reduced);
+            blocks.push_back(reduced);
+        }
+        if(cancelled)
+            failure = QStringLiteral("Cancelled");
+        else if(failure.isEmpty() && blocks.empty())
+            failure = QStringLiteral("No audio");
+    }
+
+    if(core)
+        mpv_terminate_destroy(core);
+    if(fd >= 0)
+        ::close(fd);
+    unlink(fifo.constData());
+
+    QByteArray result;
+    if(failure.isEmpty()) {
+        result = envelope(blocks, buckets);
+        QSaveFile file{path};
+        if(file.open(QIODevice::WriteOnly)) {
+            QDataStream stream{&file};
+            stream << CACHE_MAGIC << CACHE_VERSION << size << modified << qint32(buckets);
+            stream.writeRawData(result.constData(), result.size());
+            if(!file.commit())
+                warning() << "Failed to store waveform of" << url;
+        }
+        debug() << "waveform of" << url << "from" << blocks.size() * BLOCK_SAMPLES << "samples in" << timer.elapsed() << "ms";
+    }
+
+    {
+        QMutexLocker locker(&m_lock);
+        m_running.remove(path);
+    }
+    if(failure.isEmpty())
+        emit ready(url, result);
+    else
+        emit failed(url, failure);
+}
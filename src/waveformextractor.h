@@ -0,0 +1,86 @@
+/*
+    Copyright (C) 2026 phonon-mpv AUTHORS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHONON_MPV_WAVEFORMEXTRACTOR_H
+#define PHONON_MPV_WAVEFORMEXTRACTOR_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QThreadPool>
+#include <QUrl>
+
+#include <atomic>
+
+namespace Phonon::MPV {
+
+    /** \brief Computes and caches the min/max/RMS envelope of audio files
+    *
+    * A seek bar overview needs the envelope of the whole file. The extractor decodes the
+    * file faster than realtime on a core without outputs, whose pcm audio output writes
+    * mono float samples into a FIFO. A worker reduces them into fixed-size buckets.
+    *
+    * Envelopes are stored in the cache directory, keyed by path, size and modification
+    * time of the file. A cached envelope is a few kilobytes read in one go.
+    *
+    * An envelope is a QByteArray of \c qint16 triplets (min, max, RMS) in native byte order,
+    * one per bucket, scaled so that 32767 is full scale.
+    */
+    class WaveformExtractor : public QObject {
+        Q_OBJECT
+
+    public:
+        explicit WaveformExtractor(QObject* parent = nullptr);
+        ~WaveformExtractor() Q_DECL_OVERRIDE;
+
+        /**
+        * Requests the envelope of the local file \p url in \p buckets buckets. Answers from
+        * the cache right away, otherwise ready() or failed() follow from a worker thread.
+        */
+        Q_INVOKABLE void request(const QUrl& url, int buckets = 1024);
+
+        /// \return The cached envelope of \p url in \p buckets buckets, empty if there is none.
+        Q_INVOKABLE QByteArray cached(const QUrl& url, int buckets = 1024) const;
+
+        /// Aborts running and queued extractions, failed() reports them as cancelled.
+        Q_INVOKABLE void cancel();
+
+    Q_SIGNALS:
+        void ready(const QUrl& url, const QByteArray& envelope);
+        void failed(const QUrl& url, const QString& error);
+
+    private:
+        /// Runs on m_workers, decodes \p url and stores its envelope unless cancelled after \p generation.
+        void extract(const QUrl& url, int buckets, quint64 generation);
+
+        /// \return The cache file of \p url in \p buckets buckets, \p size and \p modified identify the file.
+        static QString cachePath(const QUrl& url, int buckets, qint64* size, qint64* modified);
+
+        /// Guards m_running
+        QMutex m_lock;
+        /// Cache paths of running extractions, a second request for one is dropped
+        QSet<QString> m_running;
+        std::atomic<bool> m_stopping;
+        /// Incremented by cancel(), extractions requested before are aborted
+        std::atomic<quint64> m_generation;
+        QThreadPool m_workers;
+    };
+
+} // namespace Phonon::MPV
+
+#endif // PHONON_MPV_WAVEFORMEXTRACTOR_H